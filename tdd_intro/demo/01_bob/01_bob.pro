@@ -6,5 +6,8 @@ CONFIG -= app_bundle
 CONFIG -= qt
 
 SOURCES += \
+    responder.cpp \
     test.cpp
 
+HEADERS += \
+    responder.h
@@ -0,0 +1,211 @@
+#include "responder.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace
+{
+    inline bool IsBlank(char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    inline uint8_t Fold(uint8_t byte, bool ignoreCase)
+    {
+        return ignoreCase && byte >= 'A' && byte <= 'Z' ? byte - 'A' + 'a' : byte;
+    }
+
+    const char* Intern(const std::string& response, std::deque<std::string>& interned,
+                       std::unordered_map<std::string, const char*>& index)
+    {
+        auto found = index.find(response);
+        if (found != index.end())
+        {
+            return found->second;
+        }
+        // Deque elements never move, so the pointer stays valid while more responses are added
+        interned.push_back(response);
+        const char* text = interned.back().c_str();
+        index.emplace(response, text);
+        return text;
+    }
+}
+
+Responder::Responder(const std::vector<ResponderRule>& rules, const std::string& defaultResponse, bool ignoreCase)
+    : m_classCount(1)
+    , m_rowSize(0)
+{
+    for (const ResponderRule& rule : rules)
+    {
+        if (rule.pattern.empty())
+        {
+            throw std::invalid_argument("Responder rule pattern must not be empty");
+        }
+        if (rule.kind == RuleKind::Suffix && IsBlank(rule.pattern.back()))
+        {
+            throw std::invalid_argument("Responder suffix must not end in whitespace");
+        }
+    }
+
+    // Class 0 is every byte which no pattern uses
+    uint16_t foldedClass[256] = {};
+    for (const ResponderRule& rule : rules)
+    {
+        for (char c : rule.pattern)
+        {
+            uint16_t& byteClass = foldedClass[Fold(static_cast<uint8_t>(c), ignoreCase)];
+            if (byteClass == 0)
+            {
+                byteClass = static_cast<uint16_t>(m_classCount++);
+            }
+        }
+    }
+    for (size_t byte = 0; byte < 256; ++byte)
+    {
+        m_byteClass[byte] = foldedClass[Fold(static_cast<uint8_t>(byte), ignoreCase)];
+    }
+    m_rowSize = m_classCount + ExtraColumns;
+
+    // Rank 0 is the rule which wins over all others
+    std::vector<size_t> order(rules.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t left, size_t right)
+    {
+        return rules[left].priority > rules[right].priority;
+    });
+    std::vector<Rank> ranks(rules.size());
+    std::unordered_map<std::string, const char*> index;
+    m_responses.reserve(rules.size());
+    for (size_t rank = 0; rank < order.size(); ++rank)
+    {
+        ranks[order[rank]] = static_cast<Rank>(rank);
+        m_responses.push_back(Intern(rules[order[rank]].response, m_interned, index));
+    }
+    m_defaultResponse = Intern(defaultResponse, m_interned, index);
+
+    Build(rules, ranks);
+}
+
+void Responder::Build(const std::vector<ResponderRule>& rules, const std::vector<Rank>& ranks)
+{
+    const size_t classCount = m_classCount;
+    const size_t rowSize = m_rowSize;
+    auto addRow = [&](uint32_t depth)
+    {
+        if (m_rows.size() + rowSize > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::length_error("Responder rules are too large");
+        }
+        const uint32_t row = static_cast<uint32_t>(m_rows.size());
+        m_rows.resize(m_rows.size() + rowSize, 0);
+        m_rows[row + classCount + KeywordColumn] = s_noRule;
+        m_rows[row + classCount + SuffixColumn] = s_noRule;
+        m_rows[row + classCount + PrefixColumn] = s_noRule;
+        m_rows[row + classCount + DepthColumn] = depth;
+        return row;
+    };
+
+    // Trie, where transition 0 is no child yet: the root row is 0 and never a child
+    addRow(0);
+    for (size_t rule = 0; rule < rules.size(); ++rule)
+    {
+        uint32_t row = 0;
+        for (char c : rules[rule].pattern)
+        {
+            const size_t column = row + m_byteClass[static_cast<uint8_t>(c)];
+            if (m_rows[column] == 0)
+            {
+                const uint32_t child = addRow(m_rows[row + classCount + DepthColumn] + 1);
+                m_rows[column] = child;
+            }
+            row = m_rows[column];
+        }
+        const size_t column = row + classCount + (rules[rule].kind == RuleKind::Keyword ? KeywordColumn
+                                                  : rules[rule].kind == RuleKind::Suffix ? SuffixColumn
+                                                                                         : PrefixColumn);
+        m_rows[column] = std::min(m_rows[column], ranks[rule]);
+    }
+
+    // Breadth-first, so the failure row of a state is complete before the state is visited, and the transitions
+    // of a row are still trie edges until the row itself is visited.
+    // A missing transition becomes the transition of the failure row, the root stays on the root.
+    std::vector<uint32_t> failure(m_rows.size() / rowSize, 0);
+    std::deque<uint32_t> queue(1, 0);
+    while (!queue.empty())
+    {
+        const uint32_t row = queue.front();
+        queue.pop_front();
+        const uint32_t failureRow = failure[row / rowSize];
+        for (size_t byteClass = 1; byteClass < classCount; ++byteClass)
+        {
+            const uint32_t child = m_rows[row + byteClass];
+            if (child == 0)
+            {
+                m_rows[row + byteClass] = row == 0 ? 0 : m_rows[failureRow + byteClass];
+                continue;
+            }
+            const uint32_t childFailure = row == 0 ? 0 : m_rows[failureRow + byteClass];
+            failure[child / rowSize] = childFailure;
+            uint32_t& keyword = m_rows[child + classCount + KeywordColumn];
+            uint32_t& suffix = m_rows[child + classCount + SuffixColumn];
+            keyword = std::min(keyword, m_rows[childFailure + classCount + KeywordColumn]);
+            suffix = std::min(suffix, m_rows[childFailure + classCount + SuffixColumn]);
+            queue.push_back(child);
+        }
+    }
+}
+
+const char* Responder::Respond(const char* message, size_t size) const
+{
+    const uint32_t* rows = m_rows.data();
+    const uint16_t* byteClass = m_byteClass;
+    const size_t extra = m_classCount;
+    uint32_t row = 0;
+    Rank best = s_noRule;
+    Rank suffix = s_noRule;
+    // Suffix rules are taken from the state after the last non-blank byte
+    size_t end = size;
+    while (end > 0 && IsBlank(message[end - 1]))
+    {
+        --end;
+    }
+    size_t pos = 0;
+    // Prefix rules while the message so far is a path of the trie
+    while (pos < size)
+    {
+        row = rows[row + byteClass[static_cast<uint8_t>(message[pos++])]];
+        best = std::min(best, rows[row + extra + KeywordColumn]);
+        if (pos == end)
+        {
+            suffix = rows[row + extra + SuffixColumn];
+        }
+        if (rows[row + extra + DepthColumn] != pos)
+        {
+            break;
+        }
+        best = std::min(best, rows[row + extra + PrefixColumn]);
+    }
+    while (pos < size)
+    {
+        row = rows[row + byteClass[static_cast<uint8_t>(message[pos++])]];
+        best = std::min(best, rows[row + extra + KeywordColumn]);
+        if (pos == end)
+        {
+            suffix = rows[row + extra + SuffixColumn];
+        }
+    }
+    best = std::min(best, suffix);
+    return best == s_noRule ? m_defaultResponse : m_responses[best];
+}
+
+const char* Responder::Respond(const std::string& message) const
+{
+    return Respond(message.data(), message.size());
+}
+
+size_t Responder::StateCount() const
+{
+    return m_rows.size() / m_rowSize;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+ * Rule based responder, TellToBob with any number of pattern rules.
+ *
+ * A rule answers its response when its pattern is a prefix, a suffix or anywhere (keyword) in the message.
+ * Whitespace at the end of a message is ignored, so "?" as a suffix finds "Why? ".
+ * When several rules match, the one with the highest priority wins, the earlier rule on equal priorities.
+ *
+ * All patterns are compiled into one Aho-Corasick automaton with the failure links resolved into a full
+ * transition table, so a message is classified in one pass with one table lookup per byte:
+ *   - bytes which occur in no pattern share one column of the table, the others get a column each;
+ *   - a state row holds its transitions, the best keyword rule among all patterns ending there (failure chain
+ *     included), the best suffix rule, which counts only in the state after the last non-blank byte, and the
+ *     best prefix rule ending exactly there;
+ *   - a prefix rule can only match while the whole message read so far is a path from the root,
+ *     so prefix rules are only checked until the state depth falls behind the number of bytes read.
+ * Rules are ranked by priority once, so resolving a match is taking the smaller rank.
+ * Responses are interned: equal responses share one pointer, valid for the lifetime of the responder.
+*/
+
+enum class RuleKind
+{
+    Prefix,
+    Suffix,
+    Keyword
+};
+
+struct ResponderRule
+{
+    RuleKind kind;
+    std::string pattern;
+    std::string response;
+    int priority;
+};
+
+class Responder
+{
+public:
+    // Throws std::invalid_argument for an empty pattern or a suffix ending in whitespace.
+    // With ignoreCase ASCII letters match either case.
+    Responder(const std::vector<ResponderRule>& rules, const std::string& defaultResponse, bool ignoreCase = false);
+    // Responses point into the interned strings of this responder, a copy could not share them
+    Responder(const Responder&) = delete;
+    Responder& operator=(const Responder&) = delete;
+
+    const char* Respond(const char* message, size_t size) const;
+    const char* Respond(const std::string& message) const;
+
+    size_t StateCount() const;
+
+private:
+    using Rank = uint32_t;
+    static const Rank s_noRule = UINT32_MAX;
+
+    // Columns after the transitions of a row
+    enum Column
+    {
+        KeywordColumn,
+        SuffixColumn,
+        PrefixColumn,
+        DepthColumn,
+        ExtraColumns
+    };
+
+    void Build(const std::vector<ResponderRule>& rules, const std::vector<Rank>& ranks);
+
+    uint16_t m_byteClass[256];
+    size_t m_classCount;
+    // States are rows of m_rowSize entries: transitions to row offsets, then the extra columns
+    size_t m_rowSize;
+    std::vector<uint32_t> m_rows;
+    // Response of every rank
+    std::vector<const char*> m_responses;
+    const char* m_defaultResponse;
+    std::deque<std::string> m_interned;
+};
@@ -1,35 +1,142 @@
 /*
-Bob answers 'Sure.' if you ask him a question. (? in the end)
+Bob answers 'Sure.' if you ask him a question. (? is the last character which is not a space)
 
-He answers 'Whoa, chill out!' if you yell at him. (! in the end)
+He answers 'Whoa, chill out!' if you yell at him. (there are letters and all of them are capital)
 
-He says 'Fine. Be that way!' if you address him without actually saying anything.
+He says 'Fine. Be that way!' if you address him without actually saying anything. (only spaces or nothing)
 
 He answers 'Whatever.' to anything else.
 */
+#include "responder.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
 #include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BOB_SSE2
+#endif
+
+/*
+ * Architecture:
+ * A message is classified in two passes over its bytes.
+ * The backward pass skips trailing whitespace: it finds silence and the last character for questions,
+ *   and almost always stops at the first byte it looks at.
+ * The forward pass looks for letters 16 bytes per step with SSE2 and stops at the first lowercase letter,
+ *   which decides that the message is not yelling. Only all-caps messages are scanned to the end.
+ * Yelling wins over a question, silence wins over everything.
+ * The batch overload answers many messages into an array of the same static answer pointers.
+ * Letters are ASCII letters, other bytes (digits, punctuation, UTF-8 sequences) are neither case.
+*/
 
 static const char* s_whateverAnswer = "Whatever.";
 static const char* s_sureAnswer = "Sure.";
 static const char* s_fineAnswer = "Fine. Be that way!";
 static const char* s_chillOutAnswer = "Whoa, chill out!";
 
-const char* TellToBob(const std::string& message)
+inline bool IsBlank(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Sets hasUpper if text has capital letters, returns true as soon as a lowercase letter is found
+inline bool FindLowercase(const char* text, size_t size, bool& hasUpper)
+{
+    size_t pos = 0;
+#ifdef BOB_SSE2
+    // Bytes above 0x7F are negative in signed comparisons, so they are outside both ranges
+    const __m128i beforeUpper = _mm_set1_epi8('A' - 1);
+    const __m128i afterUpper = _mm_set1_epi8('Z' + 1);
+    const __m128i beforeLower = _mm_set1_epi8('a' - 1);
+    const __m128i afterLower = _mm_set1_epi8('z' + 1);
+    __m128i upper = _mm_setzero_si128();
+    for (; pos + 16 <= size; pos += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos));
+        const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeLower), _mm_cmplt_epi8(bytes, afterLower));
+        upper = _mm_or_si128(upper,
+                             _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeUpper), _mm_cmplt_epi8(bytes, afterUpper)));
+        if (_mm_movemask_epi8(lower) != 0)
+        {
+            return true;
+        }
+    }
+    hasUpper = hasUpper || _mm_movemask_epi8(upper) != 0;
+#endif
+    for (; pos < size; ++pos)
+    {
+        const char c = text[pos];
+        if (c >= 'a' && c <= 'z')
+        {
+            return true;
+        }
+        hasUpper = hasUpper || (c >= 'A' && c <= 'Z');
+    }
+    return false;
+}
+
+const char* TellToBob(const char* message, size_t size)
 {
-    if (message.empty())
+    size_t end = size;
+    while (end > 0 && IsBlank(message[end - 1]))
+    {
+        --end;
+    }
+    if (end == 0)
     {
         return s_fineAnswer;
     }
-    if (message.back() == '?')
+    bool hasUpper = false;
+    if (!FindLowercase(message, end, hasUpper) && hasUpper)
+    {
+        return s_chillOutAnswer;
+    }
+    if (message[end - 1] == '?')
     {
         return s_sureAnswer;
     }
-    else if (message.back() == '!')
+    return s_whateverAnswer;
+}
+
+const char* TellToBob(const std::string& message)
+{
+    return TellToBob(message.data(), message.size());
+}
+
+// Answers messages[i] into answers[i]
+void TellToBob(const std::string* messages, size_t count, const char** answers)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        answers[i] = TellToBob(messages[i].data(), messages[i].size());
+    }
+}
+
+// Straightforward reference with <cctype>
+const char* TellToBobNaive(const std::string& message)
+{
+    const size_t last = message.find_last_not_of(" \t\n\v\f\r");
+    if (last == std::string::npos)
+    {
+        return s_fineAnswer;
+    }
+    bool hasUpper = false;
+    bool hasLower = false;
+    for (char c : message)
+    {
+        hasUpper = hasUpper || std::isupper(static_cast<unsigned char>(c));
+        hasLower = hasLower || std::islower(static_cast<unsigned char>(c));
+    }
+    if (hasUpper && !hasLower)
     {
         return s_chillOutAnswer;
     }
-    return s_whateverAnswer;
+    return message[last] == '?' ? s_sureAnswer : s_whateverAnswer;
 }
 
 TEST(Bob, Whatever)
@@ -54,5 +161,355 @@ TEST(Bob, Fine)
 
 TEST(Bob, ChillOut)
 {
-    ASSERT_STREQ(s_chillOutAnswer, TellToBob("Answer something different!"));
+    ASSERT_STREQ(s_chillOutAnswer, TellToBob("ANSWER SOMETHING DIFFERENT!"));
+}
+
+TEST(Bob, ExclamationIsNotYelling)
+{
+    ASSERT_STREQ(s_whateverAnswer, TellToBob("Answer something different!"));
+}
+
+TEST(Bob, YellingWithoutExclamation)
+{
+    ASSERT_STREQ(s_chillOutAnswer, TellToBob("I HATE THE DENTIST"));
+    ASSERT_STREQ(s_chillOutAnswer, TellToBob("1, 2, 3 GO!"));
+}
+
+TEST(Bob, NoLettersIsNotYelling)
+{
+    ASSERT_STREQ(s_whateverAnswer, TellToBob("1, 2, 3"));
+    ASSERT_STREQ(s_sureAnswer, TellToBob("4?"));
+}
+
+TEST(Bob, YellingQuestion)
+{
+    ASSERT_STREQ(s_chillOutAnswer, TellToBob("WHAT'S GOING ON?"));
+}
+
+TEST(Bob, QuestionWithTrailingSpaces)
+{
+    ASSERT_STREQ(s_sureAnswer, TellToBob("Okay if like my  spacebar  quite a bit?   "));
+    ASSERT_STREQ(s_whateverAnswer, TellToBob("Is that a question? No."));
+}
+
+TEST(Bob, SilenceIsWhitespace)
+{
+    ASSERT_STREQ(s_fineAnswer, TellToBob("          "));
+    ASSERT_STREQ(s_fineAnswer, TellToBob("\t\t\n \r\n"));
+}
+
+TEST(Bob, LongMessages)
+{
+    ASSERT_STREQ(s_chillOutAnswer, TellToBob("THIS MESSAGE IS LONGER THAN A FEW SIMD REGISTERS AND STILL YELLS"));
+    ASSERT_STREQ(s_whateverAnswer, TellToBob("THIS MESSAGE IS LONGER THAN A FEW SIMD REGISTERS BUT ENDS QUIETLy"));
+    ASSERT_STREQ(s_sureAnswer, TellToBob("1234567890123456789012345678901234567890 ok?"));
+    ASSERT_STREQ(s_chillOutAnswer, TellToBob("\xC3\x9C\xC3\x9C\xC3\x9C\xC3\x9C\xC3\x9C\xC3\x9C\xC3\x9C\xC3\x9C BERALL!"));
+}
+
+// Messages of every kind with lengths from 0 to 200 bytes
+std::vector<std::string> MakeMessages(size_t count)
+{
+    const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ,.!?'\t\n\x80\xFF";
+    std::vector<std::string> messages;
+    uint32_t seed = 12345;
+    auto random = [&seed](uint32_t range)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % range;
+    };
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string message;
+        const uint32_t kind = random(4);
+        const uint32_t size = random(200);
+        for (uint32_t j = 0; j < size; ++j)
+        {
+            // No lowercase letters for the yelling kind, whitespace only for the silent one
+            char c = alphabet[random(sizeof(alphabet) - 1)];
+            if (kind == 0)
+            {
+                c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+            }
+            else if (kind == 1)
+            {
+                c = " \t\n"[random(3)];
+            }
+            message += c;
+        }
+        if (kind == 2)
+        {
+            message += random(2) ? "?" : "? \n";
+        }
+        messages.push_back(message);
+    }
+    return messages;
+}
+
+TEST(Bob, BatchMatchesNaive)
+{
+    const std::vector<std::string> messages = MakeMessages(20000);
+    std::vector<const char*> answers(messages.size());
+    TellToBob(messages.data(), messages.size(), answers.data());
+    const char* kinds[] = {s_whateverAnswer, s_sureAnswer, s_fineAnswer, s_chillOutAnswer};
+    size_t counts[4] = {};
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        ASSERT_STREQ(TellToBobNaive(messages[i]), answers[i]) << messages[i];
+        counts[std::find(kinds, kinds + 4, answers[i]) - kinds]++;
+    }
+    for (size_t count : counts)
+    {
+        ASSERT_LT(1000u, count);
+    }
+}
+
+TEST(BobBenchmark, DISABLED_Batch)
+{
+    const std::vector<std::string> messages = MakeMessages(1000000);
+    size_t bytes = 0;
+    for (const std::string& message : messages)
+    {
+        bytes += message.size();
+    }
+    std::vector<const char*> answers(messages.size());
+    const size_t repeats = 10;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        TellToBob(messages.data(), messages.size(), answers.data());
+    }
+    auto time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "batch: " << repeats * messages.size() / time << " M messages/s, "
+              << repeats * bytes / time << " MB/s" << std::endl;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            answers[i] = TellToBobNaive(messages[i]);
+        }
+    }
+    time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "naive: " << repeats * messages.size() / time << " M messages/s, "
+              << repeats * bytes / time << " MB/s" << std::endl;
+}
+
+// Straightforward reference: every rule is searched on its own, the best rule by priority and then order wins
+const char* RespondNaive(const std::vector<ResponderRule>& rules, const char* defaultResponse,
+                         const std::string& message)
+{
+    const size_t last = message.find_last_not_of(" \t\n\v\f\r");
+    const std::string trimmed = last == std::string::npos ? std::string() : message.substr(0, last + 1);
+    const ResponderRule* best = nullptr;
+    for (const ResponderRule& rule : rules)
+    {
+        const size_t size = rule.pattern.size();
+        bool matches = false;
+        switch (rule.kind)
+        {
+        case RuleKind::Prefix:
+            matches = message.compare(0, size, rule.pattern) == 0;
+            break;
+        case RuleKind::Suffix:
+            matches = trimmed.size() >= size && trimmed.compare(trimmed.size() - size, size, rule.pattern) == 0;
+            break;
+        case RuleKind::Keyword:
+            matches = message.find(rule.pattern) != std::string::npos;
+            break;
+        }
+        if (matches && (best == nullptr || rule.priority > best->priority))
+        {
+            best = &rule;
+        }
+    }
+    return best == nullptr ? defaultResponse : best->response.c_str();
+}
+
+// Rules and messages over a small alphabet, so that rules match often
+std::vector<ResponderRule> MakeRules(size_t count, uint32_t seed)
+{
+    const char alphabet[] = "abcdefgh";
+    auto random = [&seed](uint32_t range)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % range;
+    };
+    std::vector<ResponderRule> rules;
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string pattern;
+        const uint32_t size = 2 + random(7);
+        for (uint32_t j = 0; j < size; ++j)
+        {
+            pattern += alphabet[random(sizeof(alphabet) - 1)];
+        }
+        const RuleKind kinds[] = {RuleKind::Prefix, RuleKind::Suffix, RuleKind::Keyword};
+        rules.push_back(ResponderRule{kinds[random(3)], pattern, "response " + std::to_string(random(50)),
+                                      static_cast<int>(random(10))});
+    }
+    return rules;
+}
+
+std::vector<std::string> MakeRuleMessages(size_t count, uint32_t seed)
+{
+    const char alphabet[] = "abcdefgh ABCDEFGH?! \n";
+    auto random = [&seed](uint32_t range)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % range;
+    };
+    std::vector<std::string> messages;
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::string message;
+        const uint32_t size = random(200);
+        for (uint32_t j = 0; j < size; ++j)
+        {
+            message += alphabet[random(sizeof(alphabet) - 1)];
+        }
+        messages.push_back(message);
+    }
+    return messages;
+}
+
+TEST(Responder, DefaultWithoutMatch)
+{
+    Responder responder({{RuleKind::Keyword, "refund", "Sorry to hear that.", 0}}, "Whatever.");
+    ASSERT_STREQ("Whatever.", responder.Respond("My name is Todd"));
+    ASSERT_STREQ("Whatever.", responder.Respond(""));
+}
+
+TEST(Responder, KindsMatchTheirPosition)
+{
+    Responder responder({{RuleKind::Prefix, "hello", "Hi!", 0},
+                         {RuleKind::Suffix, "thanks", "You are welcome.", 0},
+                         {RuleKind::Keyword, "refund", "Sorry to hear that.", 0}},
+                        "Whatever.");
+    ASSERT_STREQ("Hi!", responder.Respond("hello there"));
+    ASSERT_STREQ("Whatever.", responder.Respond("I said hello"));
+    ASSERT_STREQ("You are welcome.", responder.Respond("many thanks \n"));
+    ASSERT_STREQ("Whatever.", responder.Respond("thanks a lot"));
+    ASSERT_STREQ("Sorry to hear that.", responder.Respond("a refund, please"));
+}
+
+TEST(Responder, HigherPriorityWins)
+{
+    Responder responder({{RuleKind::Keyword, "refund", "Sorry to hear that.", 1},
+                         {RuleKind::Suffix, "?", "Sure.", 0},
+                         {RuleKind::Keyword, "order", "Let me check.", 1}},
+                        "Whatever.");
+    ASSERT_STREQ("Sure.", responder.Respond("Where is it?"));
+    ASSERT_STREQ("Sorry to hear that.", responder.Respond("Can I get a refund?"));
+    // Equal priorities, the earlier rule wins wherever the patterns are
+    ASSERT_STREQ("Sorry to hear that.", responder.Respond("order refund"));
+}
+
+TEST(Responder, OverlappingPatterns)
+{
+    Responder responder({{RuleKind::Keyword, "hers", "hers", 3},
+                         {RuleKind::Keyword, "she", "she", 2},
+                         {RuleKind::Keyword, "he", "he", 1},
+                         {RuleKind::Suffix, "sh", "sh", 4},
+                         {RuleKind::Prefix, "us", "us", 0}},
+                        "none");
+    ASSERT_STREQ("hers", responder.Respond("ushers"));
+    ASSERT_STREQ("she", responder.Respond("ushe"));
+    ASSERT_STREQ("he", responder.Respond("the"));
+    ASSERT_STREQ("sh", responder.Respond("hers push"));
+    ASSERT_STREQ("us", responder.Respond("usual"));
+}
+
+TEST(Responder, IgnoreCase)
+{
+    const std::vector<ResponderRule> rules = {{RuleKind::Keyword, "Refund", "Sorry to hear that.", 0}};
+    ASSERT_STREQ("Whatever.", Responder(rules, "Whatever.").Respond("REFUND NOW"));
+    ASSERT_STREQ("Sorry to hear that.", Responder(rules, "Whatever.", true).Respond("REFUND NOW"));
+    ASSERT_STREQ("Sorry to hear that.", Responder(rules, "Whatever.", true).Respond("refund now"));
+}
+
+TEST(Responder, InternedResponses)
+{
+    Responder responder({{RuleKind::Prefix, "hi", "Hello.", 0},
+                         {RuleKind::Prefix, "hello", "Hello.", 0},
+                         {RuleKind::Suffix, "?", "Whatever.", 0}},
+                        "Whatever.");
+    ASSERT_EQ(responder.Respond("hi"), responder.Respond("hello"));
+    ASSERT_EQ(responder.Respond("why?"), responder.Respond("ok"));
+}
+
+TEST(Responder, BobQuestions)
+{
+    Responder responder({{RuleKind::Suffix, "?", s_sureAnswer, 0}}, s_whateverAnswer);
+    const char* messages[] = {"Are you robot?", "You Bob?", "Why?  \t", "My name is Todd", "?!"};
+    for (const char* message : messages)
+    {
+        ASSERT_STREQ(TellToBob(message), responder.Respond(message)) << message;
+    }
+}
+
+TEST(Responder, RejectsBadPatterns)
+{
+    ASSERT_THROW(Responder({{RuleKind::Keyword, "", "empty", 0}}, "Whatever."), std::invalid_argument);
+    ASSERT_THROW(Responder({{RuleKind::Suffix, "? ", "blank", 0}}, "Whatever."), std::invalid_argument);
+}
+
+TEST(Responder, MatchesNaive)
+{
+    const std::vector<ResponderRule> rules = MakeRules(300, 1);
+    const Responder responder(rules, "default");
+    size_t defaults = 0;
+    for (const std::string& message : MakeRuleMessages(5000, 2))
+    {
+        const char* expected = RespondNaive(rules, "default", message);
+        ASSERT_STREQ(expected, responder.Respond(message)) << message;
+        defaults += std::string(expected) == "default";
+    }
+    ASSERT_LT(100u, defaults);
+    ASSERT_GT(4900u, defaults);
+}
+
+TEST(ResponderBenchmark, DISABLED_Rules)
+{
+    const std::vector<std::string> messages = MakeRuleMessages(100000, 2);
+    size_t bytes = 0;
+    for (const std::string& message : messages)
+    {
+        bytes += message.size();
+    }
+    const size_t repeats = 10;
+    for (size_t ruleCount : {100, 1000, 10000})
+    {
+        const std::vector<ResponderRule> rules = MakeRules(ruleCount, 1);
+        auto start = std::chrono::steady_clock::now();
+        const Responder responder(rules, "default");
+        auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << ruleCount << " rules: " << responder.StateCount() << " states, built in " << time << " ms"
+                  << std::endl;
+
+        size_t matched = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t repeat = 0; repeat < repeats; ++repeat)
+        {
+            for (const std::string& message : messages)
+            {
+                matched += *responder.Respond(message) == 'r';
+            }
+        }
+        time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  automaton: " << repeats * messages.size() / time << " M messages/s, "
+                  << repeats * bytes / time << " MB/s, " << matched / repeats << " matched" << std::endl;
+
+        // The naive reference is slow enough for one pass over a tenth of the messages
+        const size_t naiveCount = messages.size() / 10;
+        matched = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < naiveCount; ++i)
+        {
+            matched += *RespondNaive(rules, "default", messages[i]) == 'r';
+        }
+        time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "  naive: " << naiveCount / time << " M messages/s" << std::endl;
+    }
 }
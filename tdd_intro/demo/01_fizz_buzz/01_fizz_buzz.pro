@@ -4,6 +4,15 @@ TEMPLATE = app
 CONFIG += console c++11
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 SOURCES += \
-    test.cpp
+    test.cpp \
+    fizzbuzzsequence.cpp \
+    fizzbuzzrules.cpp \
+    fizzbuzzwriter.cpp
+
+HEADERS += \
+    fizzbuzzsequence.h \
+    fizzbuzzrules.h \
+    fizzbuzzwriter.h
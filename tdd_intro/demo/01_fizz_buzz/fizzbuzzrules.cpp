@@ -0,0 +1,205 @@
+#include "fizzbuzzrules.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+RuleEngine::RuleEngine(FizzBuzzRules rules)
+    : m_rules(std::move(rules))
+    , m_maxLineSize(FizzBuzzSequence::s_maxLineSize)
+{
+    size_t allWords = 1;
+    for (const FizzBuzzRule& rule : m_rules)
+    {
+        if (rule.divisor == 0)
+        {
+            throw std::invalid_argument("FizzBuzz rule divisor must be positive");
+        }
+        allWords += rule.word.size();
+    }
+    m_maxLineSize = std::max(m_maxLineSize, allWords);
+
+    // Greedy split into consecutive groups with periods up to s_maxPeriod
+    auto first = m_rules.cbegin();
+    size_t period = 1;
+    for (auto rule = m_rules.cbegin(); rule != m_rules.cend(); ++rule)
+    {
+        const size_t extended = rule_detail::Lcm(period, rule->divisor, s_maxPeriod);
+        if (extended > s_maxPeriod && rule != first)
+        {
+            AddGroup(first, rule, period);
+            first = rule;
+            period = rule_detail::Lcm(1, rule->divisor, s_maxPeriod);
+        }
+        else
+        {
+            period = extended;
+        }
+    }
+    AddGroup(first, m_rules.cend(), period);
+}
+
+void RuleEngine::AddGroup(FizzBuzzRules::const_iterator first, FizzBuzzRules::const_iterator last, size_t period)
+{
+    Group group;
+    if (period > s_maxPeriod)
+    {
+        group.period = first->divisor;
+        group.word = first->word;
+        m_groups.push_back(std::move(group));
+        return;
+    }
+
+    group.period = period;
+    group.entries.resize(period);
+    for (size_t phase = 0; phase < period; ++phase)
+    {
+        const size_t offset = group.answers.size();
+        for (auto rule = first; rule != last; ++rule)
+        {
+            if (phase % rule->divisor == 0)
+            {
+                group.answers += rule->word;
+            }
+        }
+        group.entries[phase] = Entry{offset, group.answers.size() - offset};
+    }
+    m_groups.push_back(std::move(group));
+}
+
+size_t RuleEngine::Period() const
+{
+    return m_groups.size() == 1 && !m_groups[0].entries.empty() ? m_groups[0].period : 0;
+}
+
+std::string RuleEngine::Answer(size_t number) const
+{
+    std::string answer;
+    for (const Group& group : m_groups)
+    {
+        const size_t phase = number % group.period;
+        if (group.entries.empty())
+        {
+            answer += phase == 0 ? group.word : std::string();
+            continue;
+        }
+        const Entry& entry = group.entries[phase];
+        answer.append(group.answers, entry.offset, entry.size);
+    }
+    return answer;
+}
+
+std::string RuleEngine::AnswerAt(size_t phase) const
+{
+    const Group& group = m_groups[0];
+    const Entry& entry = group.entries[phase];
+    return group.answers.substr(entry.offset, entry.size);
+}
+
+RuleEngine::Sequence::Sequence(const RuleEngine& engine, size_t first, size_t last)
+    : m_engine(engine)
+    , m_next(first)
+    , m_last(last > first ? last : first)
+    , m_counter(first)
+{
+    m_phases.reserve(engine.m_groups.size());
+    for (const Group& group : engine.m_groups)
+    {
+        m_phases.push_back(first % group.period);
+    }
+}
+
+size_t RuleEngine::Sequence::Fill(char* buffer, size_t capacity)
+{
+    if (m_engine.Period() != 0)
+    {
+        return FillFromTable(buffer, capacity);
+    }
+    const Group* groups = m_engine.m_groups.data();
+    const size_t groupCount = m_engine.m_groups.size();
+    size_t* phases = m_phases.data();
+    char* out = buffer;
+    char* const end = buffer + capacity;
+    for (; m_next < m_last && static_cast<size_t>(end - out) >= m_engine.m_maxLineSize; ++m_next)
+    {
+        char* line = out;
+        for (size_t i = 0; i < groupCount; ++i)
+        {
+            const Group& group = groups[i];
+            const size_t phase = phases[i];
+            if (!group.entries.empty())
+            {
+                const Entry& entry = group.entries[phase];
+                std::memcpy(line, group.answers.data() + entry.offset, entry.size);
+                line += entry.size;
+            }
+            else if (phase == 0)
+            {
+                std::memcpy(line, group.word.data(), group.word.size());
+                line += group.word.size();
+            }
+            phases[i] = phase + 1 == group.period ? 0 : phase + 1;
+        }
+        if (line == out)
+        {
+            std::memcpy(out, m_counter.Text(), m_counter.Size());
+            line += m_counter.Size();
+        }
+        *line++ = '\n';
+        out = line;
+        m_counter.Add(1);
+    }
+    return out - buffer;
+}
+
+size_t RuleEngine::Sequence::FillFromTable(char* buffer, size_t capacity)
+{
+    const Group& group = m_engine.m_groups[0];
+    const char* answers = group.answers.data();
+    const Entry* entries = group.entries.data();
+    size_t phase = m_phases[0];
+    char* out = buffer;
+    char* const end = buffer + capacity;
+    for (; m_next < m_last && static_cast<size_t>(end - out) >= m_engine.m_maxLineSize; ++m_next)
+    {
+        const Entry& entry = entries[phase];
+        if (entry.size != 0)
+        {
+            std::memcpy(out, answers + entry.offset, entry.size);
+            out += entry.size;
+        }
+        else
+        {
+            std::memcpy(out, m_counter.Text(), m_counter.Size());
+            out += m_counter.Size();
+        }
+        *out++ = '\n';
+        phase = phase + 1 == group.period ? 0 : phase + 1;
+        m_counter.Add(1);
+    }
+    m_phases[0] = phase;
+    return out - buffer;
+}
+
+bool RuleEngine::Sequence::Done() const
+{
+    return m_next >= m_last;
+}
+
+std::string RuleText(const RuleEngine& engine, size_t first, size_t last)
+{
+    std::string text;
+    RuleEngine::Sequence sequence(engine, first, last);
+    std::vector<char> buffer(1 << 12);
+    while (!sequence.Done())
+    {
+        const size_t size = sequence.Fill(buffer.data(), buffer.size());
+        if (size == 0)
+        {
+            // Room for the longest line of very long words
+            buffer.resize(buffer.size() * 2);
+        }
+        text.append(buffer.data(), size);
+    }
+    return text;
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "fizzbuzzsequence.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * FizzBuzz with any set of rules "multiple of divisor = word".
+ *
+ * The answer for a number is the concatenation of the words of all rules whose divisor divides it, in rule order.
+ * Answers repeat with the least common multiple of the divisors, so RuleEngine builds the answers of one
+ * period once and then answering a number is one table lookup. Sequences step through the table without any
+ * division. When the period exceeds s_maxPeriod, consecutive rules are split into groups whose periods fit,
+ * every group gets its own table and a line is the concatenation of one lookup per group. A rule whose divisor
+ * alone exceeds the limit is a group without a table, which only counts down to its next multiple.
+ *
+ * StaticRuleEngine takes the rules as a template parameter pack, Rule<3, 'F', 'i', 'z', 'z'>,
+ * checks them at compile time and shares one RuleEngine per rule set. Its period is a compile-time constant,
+ * so the single modulo of Answer compiles to a multiplication.
+*/
+
+struct FizzBuzzRule
+{
+    size_t divisor;
+    std::string word;
+};
+
+using FizzBuzzRules = std::vector<FizzBuzzRule>;
+
+class RuleEngine
+{
+public:
+    static const size_t s_maxPeriod = 1 << 16;
+
+    // Throws std::invalid_argument for a zero divisor
+    explicit RuleEngine(FizzBuzzRules rules);
+
+    // Least common multiple of the divisors, 0 when it is above s_maxPeriod and there is no single table
+    size_t Period() const;
+    // Empty when no rule matches
+    std::string Answer(size_t number) const;
+    // Answer for a number with number % Period() == phase, only valid when there is a single table
+    std::string AnswerAt(size_t phase) const;
+
+    // Lines of the numbers of [first, last) as FizzBuzzSequence writes them, with the answers of the rules
+    class Sequence
+    {
+    public:
+        Sequence(const RuleEngine& engine, size_t first, size_t last);
+
+        // Writes lines of the following numbers, never a partial line, and returns the number of bytes written.
+        // A line is written only when capacity has room for the longest possible line.
+        size_t Fill(char* buffer, size_t capacity);
+        bool Done() const;
+
+    private:
+        // One table and no concatenation
+        size_t FillFromTable(char* buffer, size_t capacity);
+
+        const RuleEngine& m_engine;
+        size_t m_next;
+        size_t m_last;
+        // m_next % period of every group
+        std::vector<size_t> m_phases;
+        DecimalCounter m_counter;
+    };
+
+private:
+    struct Entry
+    {
+        size_t offset;
+        size_t size;
+    };
+
+    // Consecutive rules answered together
+    struct Group
+    {
+        size_t period;
+        // Answers of one period indexed by entries, no entries for a single rule above s_maxPeriod
+        std::string answers;
+        std::vector<Entry> entries;
+        // The word of a group without entries, answered at phase 0
+        std::string word;
+    };
+
+    void AddGroup(FizzBuzzRules::const_iterator first, FizzBuzzRules::const_iterator last, size_t period);
+
+    FizzBuzzRules m_rules;
+    std::vector<Group> m_groups;
+    // Room a sequence needs for any line: all words or the longest number, and a line feed
+    size_t m_maxLineSize;
+};
+
+// All lines of [first, last) in one string
+std::string RuleText(const RuleEngine& engine, size_t first, size_t last);
+
+template <size_t Divisor, char... Letters>
+struct Rule
+{
+    static_assert(Divisor > 0, "Rule divisor must be positive");
+    static_assert(sizeof...(Letters) > 0, "Rule word must not be empty");
+
+    static const size_t divisor = Divisor;
+
+    static FizzBuzzRule Get()
+    {
+        const char word[] = {Letters...};
+        return FizzBuzzRule{Divisor, std::string(word, sizeof(word))};
+    }
+};
+
+namespace rule_detail
+{
+    constexpr size_t Gcd(size_t left, size_t right)
+    {
+        return right == 0 ? left : Gcd(right, left % right);
+    }
+
+    // Any result above limit is limit + 1, so a large rule set can not overflow
+    constexpr size_t Lcm(size_t left, size_t right, size_t limit)
+    {
+        return left > limit || right / Gcd(left, right) > limit / left ? limit + 1 : left * (right / Gcd(left, right));
+    }
+
+    template <size_t... Divisors>
+    struct Period;
+
+    template <>
+    struct Period<>
+    {
+        static const size_t value = 1;
+    };
+
+    template <size_t Divisor, size_t... Rest>
+    struct Period<Divisor, Rest...>
+    {
+        static const size_t value = Lcm(Period<Rest...>::value, Divisor, RuleEngine::s_maxPeriod);
+    };
+}
+
+template <typename... Rules>
+class StaticRuleEngine
+{
+public:
+    static const size_t s_period = rule_detail::Period<Rules::divisor...>::value;
+    static_assert(sizeof...(Rules) > 0, "Rule set must not be empty");
+    static_assert(s_period <= RuleEngine::s_maxPeriod, "Rule set period is too large for a compile-time rule set");
+
+    static const RuleEngine& Engine()
+    {
+        static const RuleEngine s_engine(FizzBuzzRules{Rules::Get()...});
+        return s_engine;
+    }
+
+    static std::string Answer(size_t number)
+    {
+        return Engine().AnswerAt(number % s_period);
+    }
+};
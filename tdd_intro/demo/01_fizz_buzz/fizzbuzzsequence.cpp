@@ -0,0 +1,234 @@
+#include "fizzbuzzsequence.h"
+#include <cstring>
+
+namespace
+{
+    enum class Answer
+    {
+        Number,
+        Fizz,
+        Buzz,
+        FizzBuzz
+    };
+
+    // Answer for every remainder of division by 15
+    const Answer s_pattern[15] = {
+        Answer::FizzBuzz, Answer::Number, Answer::Number, Answer::Fizz, Answer::Number,
+        Answer::Buzz, Answer::Fizz, Answer::Number, Answer::Number, Answer::Fizz,
+        Answer::Buzz, Answer::Number, Answer::Fizz, Answer::Number, Answer::Number
+    };
+
+    const char s_fizz[] = "Fizz\n";
+    const char s_buzz[] = "Buzz\n";
+    const char s_fizzBuzz[] = "FizzBuzz\n";
+    const size_t s_fizzSize = sizeof(s_fizz) - 1;
+    const size_t s_buzzSize = sizeof(s_buzz) - 1;
+    const size_t s_fizzBuzzSize = sizeof(s_fizzBuzz) - 1;
+
+    // Line endings of the numbers below s_lowLines: three digits and a line feed
+    const size_t s_lowDigits = 3;
+    const unsigned s_lowLines = 1000;
+
+    struct LowLines
+    {
+        char text[s_lowLines][s_lowDigits + 1];
+
+        LowLines()
+        {
+            for (unsigned number = 0; number < s_lowLines; ++number)
+            {
+                text[number][0] = static_cast<char>('0' + number / 100);
+                text[number][1] = static_cast<char>('0' + number / 10 % 10);
+                text[number][2] = static_cast<char>('0' + number % 10);
+                text[number][3] = '\n';
+            }
+        }
+    };
+
+    const LowLines& GetLowLines()
+    {
+        static const LowLines s_lines;
+        return s_lines;
+    }
+
+    // Eight numbers, four Fizz, two Buzz and a FizzBuzz
+    const size_t s_maxPeriodSize = 8 * FizzBuzzSequence::s_maxLineSize + 4 * s_fizzSize + 2 * s_buzzSize + s_fizzBuzzSize;
+}
+
+DecimalCounter::DecimalCounter(size_t value)
+    : m_size(0)
+{
+    std::memset(m_digits, 0, sizeof(m_digits));
+    m_digits[s_lineFeed] = '\n';
+    do
+    {
+        ++m_size;
+        m_digits[s_lineFeed - m_size] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    while (value != 0);
+}
+
+void DecimalCounter::Add(unsigned delta)
+{
+    size_t pos = s_lineFeed - 1;
+    unsigned digit = m_digits[pos] - '0' + delta;
+    while (digit > 9)
+    {
+        m_digits[pos] = static_cast<char>('0' + digit - 10);
+        if (pos == s_lineFeed - m_size)
+        {
+            // Carry out of the leading digit
+            ++m_size;
+            m_digits[pos - 1] = '0';
+        }
+        --pos;
+        digit = m_digits[pos] - '0' + 1;
+    }
+    m_digits[pos] = static_cast<char>('0' + digit);
+}
+
+const char* DecimalCounter::Text() const
+{
+    return m_digits + s_lineFeed - m_size;
+}
+
+size_t DecimalCounter::Size() const
+{
+    return m_size;
+}
+
+FizzBuzzSequence::FizzBuzzSequence(size_t first, size_t last)
+    : m_next(first)
+    , m_last(last > first ? last : first)
+    , m_phase(first % 15)
+    , m_counter(first)
+{
+}
+
+size_t FizzBuzzSequence::Fill(char* buffer, size_t capacity)
+{
+    char* out = buffer;
+    char* const end = buffer + capacity;
+    while (m_next < m_last)
+    {
+        if (m_phase == 1 && m_last - m_next >= 15 &&
+            static_cast<size_t>(end - out) >= s_maxPeriodSize + DecimalCounter::s_copySize && WritePeriod(out))
+        {
+            m_next += 15;
+            continue;
+        }
+
+        const Answer answer = s_pattern[m_phase];
+        size_t size = 0;
+        switch (answer)
+        {
+        case Answer::Number:
+            size = m_counter.Size() + 1;
+            break;
+        case Answer::Fizz:
+            size = s_fizzSize;
+            break;
+        case Answer::Buzz:
+            size = s_buzzSize;
+            break;
+        case Answer::FizzBuzz:
+            size = s_fizzBuzzSize;
+            break;
+        }
+        if (static_cast<size_t>(end - out) < size)
+        {
+            break;
+        }
+        switch (answer)
+        {
+        case Answer::Number:
+            std::memcpy(out, m_counter.Text(), size);
+            break;
+        case Answer::Fizz:
+            std::memcpy(out, s_fizz, size);
+            break;
+        case Answer::Buzz:
+            std::memcpy(out, s_buzz, size);
+            break;
+        case Answer::FizzBuzz:
+            std::memcpy(out, s_fizzBuzz, size);
+            break;
+        }
+        out += size;
+        ++m_next;
+        m_phase = m_phase == 14 ? 0 : m_phase + 1;
+        m_counter.Add(1);
+    }
+    return out - buffer;
+}
+
+bool FizzBuzzSequence::Done() const
+{
+    return m_next >= m_last;
+}
+
+// Writes the fifteen lines starting at a number n with n % 15 == 1, if they all share the digits above the last three.
+// Then every number line is the shared digits followed by one of the precomputed three digit endings.
+bool FizzBuzzSequence::WritePeriod(char*& out)
+{
+    const size_t size = m_counter.Size();
+    if (size <= s_lowDigits)
+    {
+        return false;
+    }
+    const char* text = m_counter.Text();
+    const unsigned low = (text[size - 3] - '0') * 100u + (text[size - 2] - '0') * 10u + (text[size - 1] - '0');
+    if (low + 14 >= s_lowLines)
+    {
+        return false;
+    }
+
+    char prefix[DecimalCounter::s_copySize];
+    std::memcpy(prefix, text, sizeof(prefix));
+    const LowLines& lowLines = GetLowLines();
+    char* line = out;
+    auto number = [&](unsigned offset)
+    {
+        std::memcpy(line, prefix, sizeof(prefix));
+        std::memcpy(line + size - s_lowDigits, lowLines.text[low + offset], sizeof(lowLines.text[0]));
+        line += size + 1;
+    };
+    auto word = [&line](const char* answer, size_t answerSize)
+    {
+        std::memcpy(line, answer, answerSize);
+        line += answerSize;
+    };
+    number(0);
+    number(1);
+    word(s_fizz, s_fizzSize);
+    number(3);
+    word(s_buzz, s_buzzSize);
+    word(s_fizz, s_fizzSize);
+    number(6);
+    number(7);
+    word(s_fizz, s_fizzSize);
+    word(s_buzz, s_buzzSize);
+    number(10);
+    word(s_fizz, s_fizzSize);
+    number(12);
+    number(13);
+    word(s_fizzBuzz, s_fizzBuzzSize);
+
+    out = line;
+    m_counter.Add(9);
+    m_counter.Add(6);
+    return true;
+}
+
+std::string FizzBuzzText(size_t first, size_t last)
+{
+    std::string text;
+    FizzBuzzSequence sequence(first, last);
+    char buffer[1 << 12];
+    while (!sequence.Done())
+    {
+        text.append(buffer, sequence.Fill(buffer, sizeof(buffer)));
+    }
+    return text;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/*
+ * Lazy FizzBuzz output for a range of numbers.
+ *
+ * Every number of [first, last) gives one line: the FizzBuzz answer, or the number itself in decimal
+ * where FizzBuzz gives none, as in the classic game. Lines end with '\n'.
+ *
+ * The answers repeat with period 15, so after one modulo in the constructor the generator only steps
+ * through a 15 entry pattern. The decimal text of the current number is kept in a DecimalCounter and
+ * advanced by one per line, so no division or to_string happens per line.
+ * When the buffer has room for a whole period and its numbers differ only in the last three digits
+ * (all but about 1.5% of periods), the period is written with stores only: the shared leading digits
+ * are copied from a local buffer and each line ending comes from a table of the 1000 three digit endings.
+*/
+
+// Decimal text of a number which is only ever increased
+class DecimalCounter
+{
+public:
+    static const size_t s_maxDigits = 20;
+
+    explicit DecimalCounter(size_t value);
+
+    // delta must be below 10
+    void Add(unsigned delta);
+    // Digits followed by a line feed
+    const char* Text() const;
+    size_t Size() const;
+    // Text is followed by a line feed and can be read s_copySize bytes at once
+    static const size_t s_copySize = 24;
+
+private:
+    // Digits end right before a line feed at s_lineFeed, the bytes after it are padding for whole copies
+    static const size_t s_lineFeed = s_maxDigits;
+    char m_digits[s_maxDigits + s_copySize];
+    size_t m_size;
+};
+
+class FizzBuzzSequence
+{
+public:
+    // Longest line: 20 digits and a line feed
+    static const size_t s_maxLineSize = DecimalCounter::s_maxDigits + 1;
+
+    FizzBuzzSequence(size_t first, size_t last);
+
+    // Writes lines of the following numbers, never a partial line, and returns the number of bytes written.
+    // Writes nothing only when the sequence is done or capacity is below the next line size.
+    size_t Fill(char* buffer, size_t capacity);
+    bool Done() const;
+
+private:
+    bool WritePeriod(char*& out);
+
+    size_t m_next;
+    size_t m_last;
+    // m_next % 15
+    unsigned m_phase;
+    // Text of m_next
+    DecimalCounter m_counter;
+};
+
+// All lines of [first, last) in one string
+std::string FizzBuzzText(size_t first, size_t last);
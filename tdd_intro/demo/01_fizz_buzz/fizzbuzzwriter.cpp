@@ -0,0 +1,301 @@
+#include "fizzbuzzwriter.h"
+#include "fizzbuzzsequence.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+namespace
+{
+    const size_t s_pageSize = 4096;
+    const size_t s_chunkBytes = 1 << 20;
+    // Largest pipe chunks are spliced into, the buffers are twice its size
+    const size_t s_maxSplicePipe = 4 << 20;
+
+    size_t DigitCount(size_t number)
+    {
+        size_t digits = 1;
+        for (; number >= 10; number /= 10)
+        {
+            ++digits;
+        }
+        return digits;
+    }
+
+    // Numbers of the chunk starting at first, whole periods except at the end of the range
+    size_t ChunkNumbers(size_t first, size_t last, size_t chunkBytes)
+    {
+        // Every line takes at least two bytes, so no number of the chunk is beyond first + chunkBytes / 2
+        const size_t reach = last - first <= chunkBytes / 2 ? last - 1 : first + chunkBytes / 2;
+        const size_t periodBytes = 8 * (DigitCount(reach) + 1) + 39;
+        return std::min(last - first, chunkBytes / periodBytes * 15);
+    }
+
+    // Page aligned chunk buffer. On Linux the pages are mapped on their own: a pipe which has the pages
+    // spliced keeps them after munmap, so the output stays intact when the buffer is gone before the reader
+    // has read it. Heap pages would be handed out again while the pipe still references them.
+    class AlignedBuffer
+    {
+    public:
+        explicit AlignedBuffer(size_t size)
+            : m_size(size)
+        {
+#if defined(__linux__)
+            void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (data == MAP_FAILED)
+            {
+                throw std::system_error(errno, std::generic_category(), "FizzBuzz buffer");
+            }
+            m_data = static_cast<char*>(data);
+#else
+            m_storage.reset(new char[size + s_pageSize]);
+            const uintptr_t address = reinterpret_cast<uintptr_t>(m_storage.get());
+            m_data = m_storage.get() + (s_pageSize - address % s_pageSize) % s_pageSize;
+#endif
+        }
+
+        ~AlignedBuffer()
+        {
+#if defined(__linux__)
+            munmap(m_data, m_size);
+#endif
+        }
+
+        AlignedBuffer(const AlignedBuffer&) = delete;
+        AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+        char* Data() const
+        {
+            return m_data;
+        }
+
+    private:
+        size_t m_size;
+        char* m_data;
+#if !defined(__linux__)
+        std::unique_ptr<char[]> m_storage;
+#endif
+    };
+
+    void WriteAll(int fd, const char* data, size_t size, bool splice)
+    {
+        while (size != 0)
+        {
+#if defined(__linux__)
+            iovec chunk = {const_cast<char*>(data), size};
+            const ssize_t written = splice ? vmsplice(fd, &chunk, 1, 0) : write(fd, data, size);
+#elif defined(_WIN32)
+            (void)splice;
+            const int written = _write(fd, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+#else
+            (void)splice;
+            const ssize_t written = write(fd, data, size);
+#endif
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "FizzBuzz output");
+            }
+            data += written;
+            size -= written;
+        }
+    }
+
+    // Chunk buffer size, and whether chunks can be spliced into fd
+    size_t PrepareOutput(int fd, bool& splice)
+    {
+        splice = false;
+#if defined(__linux__)
+        struct stat status;
+        if (fstat(fd, &status) == 0 && S_ISFIFO(status.st_mode))
+        {
+            // A smaller pipe is grown, one the caller has made larger is left as it is
+            int pipeSize = fcntl(fd, F_GETPIPE_SZ);
+            if (pipeSize > 0 && static_cast<size_t>(pipeSize) < s_chunkBytes / 2)
+            {
+                fcntl(fd, F_SETPIPE_SZ, static_cast<int>(s_chunkBytes / 2));
+                pipeSize = fcntl(fd, F_GETPIPE_SZ);
+            }
+            if (pipeSize > 0 && static_cast<size_t>(pipeSize) <= s_maxSplicePipe)
+            {
+                splice = true;
+                return 2 * static_cast<size_t>(pipeSize);
+            }
+        }
+#else
+        (void)fd;
+#endif
+        return s_chunkBytes;
+    }
+
+    class OrderedWriter
+    {
+    public:
+        OrderedWriter(int fd, size_t first, size_t last, size_t threadCount)
+            : m_fd(fd)
+            , m_first(first)
+            , m_last(last)
+            , m_threadCount(threadCount)
+            , m_chunkBytes(PrepareOutput(fd, m_splice))
+            , m_writtenChunks(0)
+            , m_writtenBytes(0)
+            , m_failed(false)
+            , m_started(false)
+        {
+        }
+
+        size_t Run()
+        {
+            std::vector<std::thread> threads;
+            try
+            {
+                for (size_t thread = 1; thread < m_threadCount; ++thread)
+                {
+                    threads.emplace_back(&OrderedWriter::Work, this, thread);
+                }
+            }
+            catch (const std::system_error&)
+            {
+                // Fewer threads than asked for: the chunks are dealt among the started ones
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_threadCount = threads.size() + 1;
+                m_started = true;
+            }
+            m_turn.notify_all();
+            Work(0);
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+            if (m_error)
+            {
+                std::rethrow_exception(m_error);
+            }
+            return m_writtenBytes;
+        }
+
+    private:
+        void Work(size_t thread)
+        {
+            try
+            {
+                {
+                    // The chunks are dealt once the number of threads is known
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_turn.wait(lock, [this] { return m_started; });
+                }
+                AlignedBuffer first(m_chunkBytes);
+                AlignedBuffer second(m_chunkBytes);
+                char* const buffers[2] = {first.Data(), second.Data()};
+                size_t current = 0;
+                size_t chunk = 0;
+                for (size_t number = m_first; number < m_last; ++chunk)
+                {
+                    const size_t numbers = ChunkNumbers(number, m_last, m_chunkBytes);
+                    if (chunk % m_threadCount == thread)
+                    {
+                        char* data = buffers[current];
+                        FizzBuzzSequence sequence(number, number + numbers);
+                        const size_t size = sequence.Fill(data, m_chunkBytes);
+                        if (!sequence.Done())
+                        {
+                            throw std::logic_error("FizzBuzz chunk does not fit its buffer");
+                        }
+                        if (!WriteInTurn(chunk, data, size))
+                        {
+                            return;
+                        }
+                        current ^= 1;
+                    }
+                    number += numbers;
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_failed)
+                {
+                    m_failed = true;
+                    m_error = std::current_exception();
+                }
+                m_turn.notify_all();
+            }
+        }
+
+        // Returns false when another thread has failed
+        bool WriteInTurn(size_t chunk, const char* data, size_t size)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_turn.wait(lock, [&] { return m_failed || m_writtenChunks == chunk; });
+                if (m_failed)
+                {
+                    return false;
+                }
+            }
+            // Only the thread of the next chunk gets here, so the output needs no lock
+            WriteAll(m_fd, data, size, m_splice);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_writtenChunks;
+                m_writtenBytes += size;
+            }
+            m_turn.notify_all();
+            return true;
+        }
+
+        int m_fd;
+        size_t m_first;
+        size_t m_last;
+        size_t m_threadCount;
+        bool m_splice;
+        size_t m_chunkBytes;
+
+        std::mutex m_mutex;
+        std::condition_variable m_turn;
+        size_t m_writtenChunks;
+        size_t m_writtenBytes;
+        bool m_failed;
+        bool m_started;
+        std::exception_ptr m_error;
+    };
+}
+
+size_t WriteFizzBuzz(int fd, size_t first, size_t last, size_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (last <= first)
+    {
+        return 0;
+    }
+    OrderedWriter writer(fd, first, last, threadCount);
+    return writer.Run();
+}
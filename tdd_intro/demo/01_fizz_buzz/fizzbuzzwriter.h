@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+
+/*
+ * Multi-threaded FizzBuzz output to a file descriptor.
+ *
+ * The range is cut into chunks of whole periods (multiples of 15 numbers). A chunk holds as many periods as fit
+ * into a chunk buffer when every number is as long as the longest number the chunk can reach, so chunk
+ * boundaries follow from the range alone and every thread walks the same plan without talking to the others.
+ * Thread t fills chunks t, t + T, t + 2T... with FizzBuzzSequence into its own two page aligned buffers
+ * and writes each chunk when all earlier chunks are written, so the output is in order.
+ *
+ * On Linux, when the descriptor is a pipe, chunks are passed with vmsplice: the pipe references the buffer
+ * pages instead of copying them. The chunk buffer size is twice the pipe size and every chunk fills more than
+ * half of its buffer, so once a thread has written its other buffer the pipe holds none of the pages of the
+ * first one and it can be refilled. This holds when the reader copies the data out of the pipe (read);
+ * a reader which splices the pages on must consume them before they are reused.
+ * The buffers are mapped with mmap rather than taken from the heap: after WriteFizzBuzz returns the pipe
+ * may still hold the last chunks, and the unmapped pages live on until they are read.
+ * A pipe smaller than 512 KiB is grown to that size and stays so; a larger one is left as it is.
+ * Everywhere else chunks are written with write.
+*/
+
+// Writes the FizzBuzzSequence lines of [first, last) to fd and returns the number of bytes written.
+// threadCount 0 means one thread per hardware thread. Throws std::system_error when writing fails.
+size_t WriteFizzBuzz(int fd, size_t first, size_t last, size_t threadCount = 0);
@@ -1,5 +1,27 @@
 #include <gtest/gtest.h>
+#include "fizzbuzzrules.h"
+#include "fizzbuzzsequence.h"
+#include "fizzbuzzwriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <cstring>
+#include <fcntl.h>
+#endif
 
 /*
  * The program should answer "Fizz" if the input number is multiple of 3, Buzz - if you specify a number which is multiple of 5,
@@ -58,3 +80,363 @@ TEST(FizzBuzzTest, Acceptance)
     EXPECT_STREQ("FizzBuzz", FizzBuzz(120).c_str());
     EXPECT_STREQ("FizzBuzz", FizzBuzz(3300).c_str());
 }
+
+// Classic game line: the answer or the number itself
+std::string FizzBuzzLine(size_t number)
+{
+    const std::string answer = FizzBuzz(number);
+    return (answer.empty() ? std::to_string(number) : answer) + '\n';
+}
+
+std::string FizzBuzzTextNaive(size_t first, size_t last)
+{
+    std::string text;
+    for (size_t number = first; number < last; ++number)
+    {
+        text += FizzBuzzLine(number);
+    }
+    return text;
+}
+
+TEST(DecimalCounter, Carries)
+{
+    DecimalCounter counter(95);
+    counter.Add(4);
+    EXPECT_EQ("99", std::string(counter.Text(), counter.Size()));
+    counter.Add(3);
+    EXPECT_EQ("102", std::string(counter.Text(), counter.Size()));
+    DecimalCounter zero(0);
+    zero.Add(9);
+    zero.Add(1);
+    EXPECT_EQ("10", std::string(zero.Text(), zero.Size()));
+    DecimalCounter large(std::numeric_limits<size_t>::max() - 9);
+    large.Add(9);
+    EXPECT_EQ(std::to_string(std::numeric_limits<size_t>::max()), std::string(large.Text(), large.Size()));
+}
+
+TEST(FizzBuzzSequence, Empty)
+{
+    EXPECT_EQ("", FizzBuzzText(5, 5));
+    EXPECT_EQ("", FizzBuzzText(7, 3));
+}
+
+TEST(FizzBuzzSequence, FirstNumbers)
+{
+    EXPECT_EQ("1\n2\nFizz\n4\nBuzz\nFizz\n7\n8\nFizz\nBuzz\n11\nFizz\n13\n14\nFizzBuzz\n16\n", FizzBuzzText(1, 17));
+    EXPECT_EQ("FizzBuzz\n", FizzBuzzText(0, 1));
+}
+
+TEST(FizzBuzzSequence, MatchesFizzBuzzAnyStart)
+{
+    for (size_t first = 0; first < 40; ++first)
+    {
+        ASSERT_EQ(FizzBuzzTextNaive(first, 1234), FizzBuzzText(first, 1234)) << first;
+    }
+    ASSERT_EQ(FizzBuzzTextNaive(999999990, 1000000100), FizzBuzzText(999999990, 1000000100));
+    const size_t max = std::numeric_limits<size_t>::max();
+    ASSERT_EQ(FizzBuzzTextNaive(max - 100, max), FizzBuzzText(max - 100, max));
+}
+
+TEST(FizzBuzzSequence, WholeLinesOnly)
+{
+    const std::string expected = FizzBuzzTextNaive(900, 2500);
+    for (size_t capacity = FizzBuzzSequence::s_maxLineSize; capacity < 300; capacity += 7)
+    {
+        FizzBuzzSequence sequence(900, 2500);
+        std::vector<char> buffer(capacity);
+        std::string text;
+        while (!sequence.Done())
+        {
+            const size_t size = sequence.Fill(buffer.data(), buffer.size());
+            ASSERT_LT(0u, size);
+            ASSERT_EQ('\n', buffer[size - 1]);
+            text.append(buffer.data(), size);
+        }
+        ASSERT_EQ(expected, text) << capacity;
+    }
+}
+
+TEST(FizzBuzzSequence, TooSmallBuffer)
+{
+    FizzBuzzSequence sequence(10, 20);
+    char buffer[2];
+    EXPECT_EQ(0u, sequence.Fill(buffer, sizeof(buffer)));
+    EXPECT_FALSE(sequence.Done());
+}
+
+TEST(FizzBuzzSequenceBenchmark, DISABLED_Throughput)
+{
+    const size_t first = 1;
+    const size_t last = 200000000;
+    std::vector<char> buffer(1 << 16);
+    size_t checksum = 0;
+
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    FizzBuzzSequence sequence(first, last);
+    while (!sequence.Done())
+    {
+        const size_t size = sequence.Fill(buffer.data(), buffer.size());
+        checksum += buffer[size - 2];
+        bytes += size;
+    }
+    auto time = std::chrono::steady_clock::now() - start;
+    std::cout << "FizzBuzzSequence: " << bytes / std::chrono::duration<double, std::milli>(time).count() / 1e6
+              << " GB/s" << std::endl;
+
+    // The naive loop is much slower, so it gets a tenth of the range
+    std::string text;
+    size_t naiveBytes = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t number = first; number < last / 10; ++number)
+    {
+        text += FizzBuzzLine(number);
+        if (text.size() >= buffer.size())
+        {
+            naiveBytes += text.size();
+            checksum += text.back();
+            text.clear();
+        }
+    }
+    time = std::chrono::steady_clock::now() - start;
+    std::cout << "FizzBuzz and to_string: " << naiveBytes / std::chrono::duration<double, std::milli>(time).count() / 1e6
+              << " GB/s (checksum " << checksum << ")" << std::endl;
+}
+
+using ClassicRules = StaticRuleEngine<Rule<3, 'F', 'i', 'z', 'z'>, Rule<5, 'B', 'u', 'z', 'z'>>;
+static_assert(ClassicRules::s_period == 15, "FizzBuzz repeats every 15 numbers");
+
+// Rules for the first primes, their period is far above RuleEngine::s_maxPeriod
+FizzBuzzRules PrimeRules(size_t count)
+{
+    const size_t primes[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47};
+    FizzBuzzRules rules;
+    for (size_t i = 0; i < count; ++i)
+    {
+        rules.push_back(FizzBuzzRule{primes[i], std::string(1, static_cast<char>('a' + i))});
+    }
+    return rules;
+}
+
+std::string RuleTextNaive(const FizzBuzzRules& rules, size_t first, size_t last)
+{
+    std::string text;
+    for (size_t number = first; number < last; ++number)
+    {
+        std::string answer;
+        for (const FizzBuzzRule& rule : rules)
+        {
+            if (number % rule.divisor == 0)
+            {
+                answer += rule.word;
+            }
+        }
+        text += (answer.empty() ? std::to_string(number) : answer) + '\n';
+    }
+    return text;
+}
+
+TEST(RuleEngine, ClassicRulesAsFizzBuzz)
+{
+    const RuleEngine engine({{3, "Fizz"}, {5, "Buzz"}});
+    EXPECT_EQ(15u, engine.Period());
+    for (size_t number = 0; number < 100; ++number)
+    {
+        ASSERT_EQ(FizzBuzz(number), engine.Answer(number)) << number;
+        ASSERT_EQ(FizzBuzz(number), ClassicRules::Answer(number)) << number;
+    }
+    EXPECT_EQ(FizzBuzzText(7, 5000), RuleText(engine, 7, 5000));
+    EXPECT_EQ(FizzBuzzText(7, 5000), RuleText(ClassicRules::Engine(), 7, 5000));
+}
+
+TEST(RuleEngine, WordsInRuleOrder)
+{
+    const RuleEngine engine({{5, "Buzz"}, {3, "Fizz"}, {7, "Bazz"}});
+    EXPECT_EQ(105u, engine.Period());
+    EXPECT_EQ("BuzzFizz", engine.Answer(15));
+    EXPECT_EQ("FizzBazz", engine.Answer(21));
+    EXPECT_EQ("BuzzFizzBazz", engine.Answer(210));
+    EXPECT_EQ("", engine.Answer(11));
+}
+
+TEST(RuleEngine, ZeroDivisor)
+{
+    EXPECT_THROW(RuleEngine({{3, "Fizz"}, {0, "Never"}}), std::invalid_argument);
+}
+
+TEST(RuleEngine, NoRules)
+{
+    const RuleEngine engine({});
+    EXPECT_EQ(1u, engine.Period());
+    EXPECT_EQ("", engine.Answer(3));
+    EXPECT_EQ("0\n1\n2\n", RuleText(engine, 0, 3));
+}
+
+TEST(RuleEngine, LargePeriodSplitIntoGroups)
+{
+    const FizzBuzzRules rules = PrimeRules(10);
+    const RuleEngine engine(rules);
+    EXPECT_EQ(0u, engine.Period());
+    EXPECT_EQ("abc", engine.Answer(30));
+    EXPECT_EQ(RuleTextNaive(rules, 0, 3000), RuleText(engine, 0, 3000));
+    EXPECT_EQ(RuleTextNaive(rules, 6469693200, 6469693300), RuleText(engine, 6469693200, 6469693300));
+}
+
+TEST(RuleEngine, TableAndGroupsAgree)
+{
+    const FizzBuzzRules rules = PrimeRules(6);
+    const RuleEngine engine(rules);
+    EXPECT_EQ(30030u, engine.Period());
+    EXPECT_EQ(RuleTextNaive(rules, 29990, 90200), RuleText(engine, 29990, 90200));
+    // A huge divisor pushes the same rules over the table limit
+    FizzBuzzRules withHuge = rules;
+    withHuge.push_back(FizzBuzzRule{std::numeric_limits<size_t>::max(), "never"});
+    const RuleEngine fallback(withHuge);
+    EXPECT_EQ(0u, fallback.Period());
+    EXPECT_EQ(RuleText(engine, 29990, 90200), RuleText(fallback, 29990, 90200));
+}
+
+TEST(RuleEngineBenchmark, DISABLED_OneTableAgainstGroups)
+{
+    const size_t count = 50000000;
+    std::vector<char> buffer(1 << 16);
+    const std::pair<const char*, FizzBuzzRules> ruleSets[] = {
+        {"classic rules, table", {{3, "Fizz"}, {5, "Buzz"}}},
+        {"5 prime rules, table", PrimeRules(5)},
+        {"12 prime rules, 3 tables", PrimeRules(12)}
+    };
+    for (const auto& ruleSet : ruleSets)
+    {
+        const RuleEngine engine(ruleSet.second);
+        RuleEngine::Sequence sequence(engine, 1, count);
+        size_t bytes = 0;
+        const auto start = std::chrono::steady_clock::now();
+        while (!sequence.Done())
+        {
+            bytes += sequence.Fill(buffer.data(), buffer.size());
+        }
+        const auto time = std::chrono::steady_clock::now() - start;
+        std::cout << ruleSet.first << ": "
+                  << count / std::chrono::duration<double, std::milli>(time).count() / 1e3 << " M numbers/s, "
+                  << bytes / std::chrono::duration<double, std::milli>(time).count() / 1e6 << " GB/s" << std::endl;
+    }
+}
+
+#if !defined(_WIN32)
+// Runs write(fd) with the write end of a pipe while another thread reads everything from it
+template <typename Write>
+size_t ReadFromPipe(Write write, std::string* text)
+{
+    int pipeEnds[2] = {-1, -1};
+    if (pipe(pipeEnds) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "pipe");
+    }
+    size_t readBytes = 0;
+    std::thread reader([&]
+    {
+        std::vector<char> buffer(1 << 20);
+        for (;;)
+        {
+            const ssize_t size = read(pipeEnds[0], buffer.data(), buffer.size());
+            if (size <= 0)
+            {
+                break;
+            }
+            if (text)
+            {
+                text->append(buffer.data(), size);
+            }
+            readBytes += size;
+        }
+    });
+    write(pipeEnds[1]);
+    close(pipeEnds[1]);
+    reader.join();
+    close(pipeEnds[0]);
+    return readBytes;
+}
+
+TEST(WriteFizzBuzz, PipeInOrder)
+{
+    const std::string expected = FizzBuzzText(1, 3000000);
+    for (size_t threadCount : {1, 2, 5})
+    {
+        std::string text;
+        size_t written = 0;
+        ReadFromPipe([&](int fd) { written = WriteFizzBuzz(fd, 1, 3000000, threadCount); }, &text);
+        ASSERT_EQ(expected.size(), written);
+        ASSERT_TRUE(expected == text) << threadCount << " threads";
+    }
+}
+
+#if defined(__linux__)
+TEST(WriteFizzBuzz, PipeKeepsOutputAfterReturn)
+{
+    // The first run frees its buffers, which raises the malloc mmap threshold, so the buffers of later runs
+    // would come from the heap
+    ReadFromPipe([&](int fd) { WriteFizzBuzz(fd, 1, 3000000, 2); }, nullptr);
+
+    int pipeEnds[2] = {-1, -1};
+    ASSERT_EQ(0, pipe(pipeEnds));
+    ASSERT_LT(0, fcntl(pipeEnds[1], F_SETPIPE_SZ, 1 << 20));
+    const std::string expected = FizzBuzzText(1, 100000);
+    ASSERT_EQ(expected.size(), WriteFizzBuzz(pipeEnds[1], 1, 100000, 2));
+    // A pipe the caller has made larger keeps its size
+    ASSERT_EQ(1 << 20, fcntl(pipeEnds[1], F_GETPIPE_SZ));
+    close(pipeEnds[1]);
+
+    // Nothing is read yet: reuse the freed memory before reading
+    std::vector<std::vector<char>> garbage;
+    for (size_t block = 0; block < 64; ++block)
+    {
+        garbage.emplace_back(1 << 16);
+        std::memset(garbage.back().data(), '#', garbage.back().size());
+    }
+    std::string text;
+    std::vector<char> buffer(1 << 16);
+    for (ssize_t size; (size = read(pipeEnds[0], buffer.data(), buffer.size())) > 0;)
+    {
+        text.append(buffer.data(), size);
+    }
+    close(pipeEnds[0]);
+    ASSERT_TRUE(expected == text);
+}
+#endif
+
+TEST(WriteFizzBuzz, File)
+{
+    FILE* file = std::tmpfile();
+    ASSERT_NE(nullptr, file);
+    EXPECT_EQ(FizzBuzzText(99990, 1234567).size(), WriteFizzBuzz(fileno(file), 99990, 1234567, 3));
+    std::string text(FizzBuzzText(99990, 1234567).size(), '\0');
+    std::rewind(file);
+    EXPECT_EQ(text.size(), std::fread(&text[0], 1, text.size(), file));
+    EXPECT_TRUE(FizzBuzzText(99990, 1234567) == text);
+    std::fclose(file);
+}
+
+TEST(WriteFizzBuzz, EmptyRange)
+{
+    EXPECT_EQ(0u, WriteFizzBuzz(1, 10, 10));
+}
+
+TEST(WriteFizzBuzz, BadDescriptor)
+{
+    EXPECT_THROW(WriteFizzBuzz(-1, 1, 100000, 2), std::system_error);
+}
+
+TEST(WriteFizzBuzzBenchmark, DISABLED_PipeThroughput)
+{
+    const size_t last = 300000000;
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threadCount = 1; threadCount <= hardwareThreads; threadCount *= 2)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t bytes = ReadFromPipe([&](int fd) { WriteFizzBuzz(fd, 1, last, threadCount); }, nullptr);
+        const auto time = std::chrono::steady_clock::now() - start;
+        std::cout << threadCount << " threads: "
+                  << bytes / std::chrono::duration<double, std::milli>(time).count() / 1e6 << " GB/s" << std::endl;
+    }
+}
+#endif
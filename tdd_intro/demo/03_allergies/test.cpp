@@ -23,3 +23,364 @@ Your program should ignore those components of the score.
 For example, if the allergy score is 257, your program should only report the eggs (1) allergy.
 */
 #include <gtest/gtest.h>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * Architecture:
+ * AllergenRegistry<N> maps N allergen names to bit positions 0..N-1 of the score.
+ *   It is a literal type, so a registry declared constexpr has its name hash table built at compile time.
+ *   Name lookup is one hash and (almost always) one probe of an open addressing table.
+ * AllergyScore<N> stores the score as ceil(N / 64) 64-bit words, bits above N are ignored.
+ * BasicAllergies<N> answers IsAllergicTo with a single bit test and lists allergies
+ *   through an iterator over set bits, which yields static names and never allocates.
+ * Allergies is the classic eight items registry from the spec with an unsigned score.
+*/
+
+inline unsigned CountTrailingZeros(uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index = 0;
+    _BitScanForward64(&index, value);
+    return static_cast<unsigned>(index);
+#else
+    unsigned count = 0;
+    while ((value & 1) == 0)
+    {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+constexpr uint64_t HashAllergenName(std::string_view name)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template <size_t N>
+class AllergyScore
+{
+public:
+    static const size_t s_words = (N + 63) / 64;
+
+    constexpr AllergyScore()
+        : m_words{}
+    { }
+
+    // Words are given from the least significant one, bits beyond N are dropped
+    constexpr AllergyScore(std::initializer_list<uint64_t> words)
+        : m_words{}
+    {
+        size_t i = 0;
+        for (uint64_t word : words)
+        {
+            if (i == s_words)
+            {
+                break;
+            }
+            m_words[i++] = word;
+        }
+        if (N % 64 != 0)
+        {
+            m_words[s_words - 1] &= (uint64_t(1) << (N % 64)) - 1;
+        }
+    }
+
+    constexpr bool Test(size_t bit) const
+    {
+        return bit < N && (m_words[bit / 64] >> (bit % 64) & 1) != 0;
+    }
+
+    constexpr uint64_t Word(size_t index) const { return m_words[index]; }
+
+private:
+    uint64_t m_words[s_words];
+};
+
+template <size_t N>
+class AllergenRegistry
+{
+public:
+    static const size_t npos = size_t(-1);
+
+    constexpr AllergenRegistry(const char* const (&names)[N])
+        : m_names{}, m_slots{}
+    {
+        for (size_t bit = 0; bit < N; ++bit)
+        {
+            if (Find(names[bit]) != npos)
+            {
+                throw std::invalid_argument("Duplicate allergen name");
+            }
+            m_names[bit] = names[bit];
+            size_t slot = HashAllergenName(names[bit]) & s_slotMask;
+            while (m_slots[slot] != 0)
+            {
+                slot = (slot + 1) & s_slotMask;
+            }
+            m_slots[slot] = static_cast<uint16_t>(bit + 1);
+        }
+    }
+
+    constexpr size_t Size() const { return N; }
+
+    constexpr const char* Name(size_t bit) const { return m_names[bit]; }
+
+    // Returns bit position of the allergen or npos if it is not registered
+    constexpr size_t Find(std::string_view name) const
+    {
+        size_t slot = HashAllergenName(name) & s_slotMask;
+        while (m_slots[slot] != 0)
+        {
+            const size_t bit = m_slots[slot] - 1u;
+            if (name == m_names[bit])
+            {
+                return bit;
+            }
+            slot = (slot + 1) & s_slotMask;
+        }
+        return npos;
+    }
+
+private:
+    static constexpr size_t SlotCount()
+    {
+        size_t count = 1;
+        while (count < 2 * N)
+        {
+            count *= 2;
+        }
+        return count;
+    }
+
+    static const size_t s_slotMask = SlotCount() - 1;
+
+    const char* m_names[N];
+    uint16_t m_slots[SlotCount()];
+};
+
+template <size_t N>
+class AllergenList
+{
+public:
+    class Iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef const char* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const char* const* pointer;
+        typedef const char* reference;
+
+        Iterator(const AllergenList& list, size_t word, uint64_t bits)
+            : m_list(&list), m_word(word), m_bits(bits)
+        {
+            SkipEmptyWords();
+        }
+
+        const char* operator*() const
+        {
+            return m_list->m_registry.Name(m_word * 64 + CountTrailingZeros(m_bits));
+        }
+
+        Iterator& operator++()
+        {
+            m_bits &= m_bits - 1;
+            SkipEmptyWords();
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return m_word == other.m_word && m_bits == other.m_bits; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+    private:
+        void SkipEmptyWords()
+        {
+            while (m_bits == 0 && m_word + 1 < AllergyScore<N>::s_words)
+            {
+                m_bits = m_list->m_score.Word(++m_word);
+            }
+        }
+
+    private:
+        const AllergenList* m_list;
+        size_t m_word;
+        uint64_t m_bits;
+    };
+
+    AllergenList(const AllergenRegistry<N>& registry, const AllergyScore<N>& score)
+        : m_registry(registry), m_score(score)
+    { }
+
+    Iterator begin() const { return Iterator(*this, 0, m_score.Word(0)); }
+    Iterator end() const { return Iterator(*this, AllergyScore<N>::s_words - 1, 0); }
+
+private:
+    const AllergenRegistry<N>& m_registry;
+    AllergyScore<N> m_score;
+};
+
+template <size_t N>
+class BasicAllergies
+{
+public:
+    BasicAllergies(const AllergenRegistry<N>& registry, const AllergyScore<N>& score)
+        : m_registry(registry), m_score(score)
+    { }
+
+    bool IsAllergicTo(size_t bit) const
+    {
+        return m_score.Test(bit);
+    }
+
+    bool IsAllergicTo(std::string_view allergen) const
+    {
+        return m_score.Test(m_registry.Find(allergen));
+    }
+
+    AllergenList<N> List() const
+    {
+        return AllergenList<N>(m_registry, m_score);
+    }
+
+private:
+    const AllergenRegistry<N>& m_registry;
+    AllergyScore<N> m_score;
+};
+
+static constexpr const char* s_classicAllergenNames[] = {
+    "eggs", "peanuts", "shellfish", "strawberries", "tomatoes", "chocolate", "pollen", "cats"
+};
+static constexpr AllergenRegistry<8> s_classicAllergens(s_classicAllergenNames);
+
+class Allergies: public BasicAllergies<8>
+{
+public:
+    explicit Allergies(unsigned score)
+        : BasicAllergies<8>(s_classicAllergens, {score})
+    { }
+};
+
+using Allergens = std::vector<std::string>;
+
+template <size_t N>
+Allergens ToAllergens(const AllergenList<N>& list)
+{
+    return Allergens(list.begin(), list.end());
+}
+
+static_assert(s_classicAllergens.Find("eggs") == 0, "eggs must be the first bit");
+static_assert(s_classicAllergens.Find("cats") == 7, "cats must be the eighth bit");
+static_assert(s_classicAllergens.Find("dogs") == AllergenRegistry<8>::npos, "dogs are not registered");
+
+TEST(Allergies, NoAllergies)
+{
+    Allergies allergies(0);
+    ASSERT_FALSE(allergies.IsAllergicTo("eggs"));
+    ASSERT_EQ(Allergens(), ToAllergens(allergies.List()));
+}
+
+TEST(Allergies, Eggs)
+{
+    Allergies allergies(1);
+    ASSERT_TRUE(allergies.IsAllergicTo("eggs"));
+    ASSERT_FALSE(allergies.IsAllergicTo("peanuts"));
+}
+
+TEST(Allergies, PeanutsAndChocolate)
+{
+    Allergies allergies(34);
+    ASSERT_TRUE(allergies.IsAllergicTo("peanuts"));
+    ASSERT_TRUE(allergies.IsAllergicTo("chocolate"));
+    ASSERT_FALSE(allergies.IsAllergicTo("cats"));
+    ASSERT_EQ(Allergens({"peanuts", "chocolate"}), ToAllergens(allergies.List()));
+}
+
+TEST(Allergies, UnknownAllergen)
+{
+    Allergies allergies(255);
+    ASSERT_FALSE(allergies.IsAllergicTo("dogs"));
+}
+
+TEST(Allergies, Everything)
+{
+    Allergies allergies(255);
+    Allergens expected = {"eggs", "peanuts", "shellfish", "strawberries", "tomatoes", "chocolate", "pollen", "cats"};
+    ASSERT_EQ(expected, ToAllergens(allergies.List()));
+}
+
+TEST(Allergies, IgnoreUnlistedComponents)
+{
+    Allergies allergies(257);
+    ASSERT_EQ(Allergens{"eggs"}, ToAllergens(allergies.List()));
+    ASSERT_FALSE(allergies.IsAllergicTo(8));
+}
+
+TEST(Allergies, CompileTimeBit)
+{
+    constexpr size_t pollen = s_classicAllergens.Find("pollen");
+    Allergies allergies(64);
+    ASSERT_TRUE(allergies.IsAllergicTo(pollen));
+}
+
+static constexpr const char* s_clinicAllergenNames[] = {
+    "eggs", "peanuts", "shellfish", "strawberries", "tomatoes", "chocolate", "pollen", "cats",
+    "dogs", "horses", "dust mites", "mold", "latex", "penicillin", "aspirin", "ibuprofen",
+    "milk", "soy", "wheat", "gluten", "sesame", "mustard", "celery", "lupin",
+    "almonds", "cashews", "walnuts", "hazelnuts", "pecans", "pistachios", "brazil nuts", "macadamia",
+    "cod", "salmon", "tuna", "shrimp", "crab", "lobster", "mussels", "oysters",
+    "squid", "kiwi", "banana", "avocado", "peach", "apple", "cherry", "mango",
+    "birch pollen", "grass pollen", "ragweed", "cockroach", "bee venom", "wasp venom", "fire ants", "nickel",
+    "cobalt", "chromium", "fragrance", "formaldehyde", "sulfites", "corn", "rice", "oats",
+    "buckwheat", "garlic", "onion", "cinnamon", "feathers", "rabbits"
+};
+static constexpr AllergenRegistry<70> s_clinicAllergens(s_clinicAllergenNames);
+
+static_assert(s_clinicAllergens.Find("rabbits") == 69, "rabbits must be the last bit");
+
+TEST(Allergies, ClinicRegistryHighWord)
+{
+    BasicAllergies<70> allergies(s_clinicAllergens, {uint64_t(1) << 1, uint64_t(1) << 5});
+    ASSERT_TRUE(allergies.IsAllergicTo("peanuts"));
+    ASSERT_TRUE(allergies.IsAllergicTo("rabbits"));
+    ASSERT_FALSE(allergies.IsAllergicTo("feathers"));
+    ASSERT_EQ(Allergens({"peanuts", "rabbits"}), ToAllergens(allergies.List()));
+}
+
+TEST(Allergies, ClinicRegistryEmptyLowWord)
+{
+    BasicAllergies<70> allergies(s_clinicAllergens, {0, 1});
+    ASSERT_EQ(Allergens{"buckwheat"}, ToAllergens(allergies.List()));
+}
+
+TEST(Allergies, ClinicRegistryIgnoresBitsAboveRegistry)
+{
+    BasicAllergies<70> allergies(s_clinicAllergens, {0, uint64_t(1) << 6, 1});
+    ASSERT_EQ(Allergens(), ToAllergens(allergies.List()));
+}
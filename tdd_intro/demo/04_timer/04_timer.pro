@@ -4,8 +4,18 @@ TEMPLATE = app
 CONFIG += console c++11
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 DEFINES += NOMINMAX
 
 SOURCES += \
-    test.cpp
+    coarsetime.cpp \
+    test.cpp \
+    timerservice.cpp \
+    timingwheel.cpp
+
+HEADERS += \
+    coarsetime.h \
+    timer.h \
+    timerservice.h \
+    timingwheel.h
@@ -0,0 +1,55 @@
+#include "coarsetime.h"
+#include <stdexcept>
+
+CoarseTime::CoarseTime(ITime& source, Duration period)
+    : m_source(source)
+    , m_period(period)
+    , m_current(source.GetCurrent().time_since_epoch().count())
+    , m_stop(false)
+{
+    if (period < s_zeroDuration)
+    {
+        throw std::invalid_argument("Coarse clock period must not be negative");
+    }
+    if (period > s_zeroDuration)
+    {
+        m_thread = std::thread(&CoarseTime::Run, this);
+    }
+}
+
+CoarseTime::~CoarseTime()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeUp.notify_all();
+        m_thread.join();
+    }
+}
+
+TimePoint CoarseTime::GetCurrent()
+{
+    return Now();
+}
+
+void CoarseTime::Update()
+{
+    const Duration::rep now = m_source.GetCurrent().time_since_epoch().count();
+    // The maximum keeps the time monotonic against a jumping source and concurrent updates
+    Duration::rep current = m_current.load(std::memory_order_relaxed);
+    while (now > current && !m_current.compare_exchange_weak(current, now, std::memory_order_relaxed))
+    {
+    }
+}
+
+void CoarseTime::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wakeUp.wait_for(lock, m_period, [this] { return m_stop; }))
+    {
+        Update();
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "timer.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+ * Coarse clock: an ITime whose reads are one relaxed atomic load.
+ *
+ * The time is a timestamp published by Update, which reads the source clock. With a positive period
+ * a background thread calls Update every period, so the time lags the source by at most about one period,
+ * like CLOCK_MONOTONIC_COARSE lags CLOCK_MONOTONIC. With a zero period the owner calls Update itself,
+ * for example once per event loop iteration, and tests get deterministic time from a FakeTime source.
+ * The published time never goes back, even when the source does.
+ *
+ * Now is the non-virtual read for code which knows the concrete clock, CoarseTimer uses it.
+*/
+
+class CoarseTime: public ITime
+{
+public:
+    // Throws std::invalid_argument for a negative period
+    CoarseTime(ITime& source, Duration period);
+    ~CoarseTime();
+    CoarseTime(const CoarseTime&) = delete;
+    CoarseTime& operator=(const CoarseTime&) = delete;
+
+    virtual TimePoint GetCurrent() override;
+
+    TimePoint Now() const
+    {
+        return TimePoint(Duration(m_current.load(std::memory_order_relaxed)));
+    }
+
+    // Reads the source and publishes its time
+    void Update();
+
+private:
+    void Run();
+
+    ITime& m_source;
+    Duration m_period;
+    std::atomic<Duration::rep> m_current;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    bool m_stop;
+    std::thread m_thread;
+};
+
+// BasicTimer time source reading a CoarseTime without a virtual call
+class CoarseTimeSource
+{
+public:
+    CoarseTimeSource(CoarseTime& time) : m_time(&time) { }
+
+    TimePoint Now() const { return m_time->Now(); }
+
+private:
+    CoarseTime* m_time;
+};
+
+typedef BasicTimer<CoarseTimeSource> CoarseTimer;
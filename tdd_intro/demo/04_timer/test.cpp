@@ -34,75 +34,27 @@ Timer can be started again any time, no metter in what state it is
  * Check the starting of timer when it is already started
 */
 
+#include "coarsetime.h"
+#include "timer.h"
+#include "timerservice.h"
+#include "timingwheel.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <time.h>
+#endif
 
 using namespace std::chrono;
-typedef high_resolution_clock Clock;
-typedef Clock::duration Duration;
-typedef time_point<Clock> TimePoint;
-static const Duration s_zeroDuration(microseconds(0));
-
-class ITimer {
-public:
-  virtual ~ITimer() {}
-
-  virtual void Start() = 0;
-  virtual bool IsExpired() const = 0;
-  virtual Duration TimeLeft() const = 0;
-};
-
-class ITime
-{
-public:
-    virtual ~ITime() { }
-
-    virtual TimePoint GetCurrent() = 0;
-};
-
-class Timer: public ITimer
-{
-public:
-    Timer(ITime& time, Duration duration)
-        : m_time(time), m_duration(duration), m_started(false)
-    { }
-
-    virtual void Start() override
-    {
-        m_started = true;
-        m_startTime = m_time.GetCurrent();
-    }
-
-    virtual bool IsExpired() const override
-    {
-        return TimeElapsed() >= m_duration;
-    }
-
-    virtual Duration TimeLeft() const override
-    {
-        if (m_started && !IsExpired())
-        {
-            return m_duration - TimeElapsed();
-        }
-        return s_zeroDuration;
-    }
-
-private:
-    Duration TimeElapsed() const
-    {
-        if (m_started)
-        {
-            return m_time.GetCurrent() - m_startTime;
-        }
-        return s_zeroDuration;
-    }
-
-private:
-    ITime& m_time;
-    Duration m_duration;
-    bool m_started;
-    TimePoint m_startTime;
-};
 
 class FakeTime: public ITime
 {
@@ -240,3 +192,700 @@ TEST(Timer, IsExpired_TimeLeaft_AfterTimerRestart)
     ASSERT_EQ(seconds(5), timer.TimeLeft());
 }
 
+
+// Collects the batches of a TimingWheel
+struct ExpiryLog
+{
+    TimingWheel::ExpiryHandler Handler()
+    {
+        return [this](const std::vector<WheelTimer*>& expired)
+        {
+            batches.push_back(std::vector<size_t>());
+            for (WheelTimer* timer : expired)
+            {
+                batches.back().push_back(timer->Id());
+            }
+        };
+    }
+
+    std::vector<std::vector<size_t>> batches;
+};
+
+TEST(TimingWheel, ITimerBehaviour)
+{
+    FakeTime time;
+    time.Wait(seconds(1));
+    ExpiryLog log;
+    TimingWheel wheel(time, milliseconds(1), log.Handler());
+    WheelTimer timer(wheel, seconds(5));
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(seconds(0), timer.TimeLeft());
+
+    timer.Start();
+    ASSERT_FALSE(timer.IsExpired());
+    ASSERT_EQ(seconds(5), timer.TimeLeft());
+
+    time.Wait(seconds(2));
+    wheel.Advance();
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+
+    // Restarting the timer
+    timer.Start();
+    ASSERT_EQ(seconds(5), timer.TimeLeft());
+
+    time.Wait(seconds(6));
+    wheel.Advance();
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(seconds(0), timer.TimeLeft());
+    ASSERT_EQ(1u, log.batches.size());
+}
+
+TEST(TimingWheel, QueriesUseTimeOfLastAdvance)
+{
+    FakeTime time;
+    ExpiryLog log;
+    TimingWheel wheel(time, milliseconds(1), log.Handler());
+    WheelTimer timer(wheel, seconds(5));
+    timer.Start();
+    time.Wait(seconds(2));
+    ASSERT_EQ(seconds(5), timer.TimeLeft());
+    wheel.Advance();
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+}
+
+TEST(TimingWheel, ZeroDurationIsExpiredAtOnce)
+{
+    FakeTime time;
+    ExpiryLog log;
+    TimingWheel wheel(time, milliseconds(1), log.Handler());
+    WheelTimer timer(wheel, s_zeroDuration, 7);
+    timer.Start();
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(1u, wheel.Advance());
+    ASSERT_EQ(std::vector<std::vector<size_t>>({{7}}), log.batches);
+}
+
+TEST(TimingWheel, FiresAtDeadlineTick)
+{
+    FakeTime time;
+    ExpiryLog log;
+    TimingWheel wheel(time, milliseconds(10), log.Handler());
+    WheelTimer timer(wheel, milliseconds(25));
+    timer.Start();
+    time.Wait(milliseconds(25));
+    ASSERT_EQ(0u, wheel.Advance());
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_TRUE(timer.IsScheduled());
+    // Deadlines are rounded up to whole ticks
+    time.Wait(milliseconds(5));
+    ASSERT_EQ(1u, wheel.Advance());
+    ASSERT_FALSE(timer.IsScheduled());
+}
+
+TEST(TimingWheel, BatchInDeadlineOrder)
+{
+    FakeTime time;
+    ExpiryLog log;
+    TimingWheel wheel(time, milliseconds(1), log.Handler());
+    WheelTimer late(wheel, milliseconds(300), 1);
+    WheelTimer early(wheel, milliseconds(100), 2);
+    WheelTimer middle(wheel, milliseconds(200), 3);
+    WheelTimer later(wheel, milliseconds(400), 4);
+    late.Start();
+    early.Start();
+    middle.Start();
+    later.Start();
+    time.Wait(milliseconds(350));
+    ASSERT_EQ(3u, wheel.Advance());
+    ASSERT_EQ(1u, wheel.Size());
+    time.Wait(milliseconds(50));
+    ASSERT_EQ(1u, wheel.Advance());
+    ASSERT_EQ(std::vector<std::vector<size_t>>({{2, 3, 1}, {4}}), log.batches);
+}
+
+TEST(TimingWheel, CancelAndDestroy)
+{
+    FakeTime time;
+    ExpiryLog log;
+    TimingWheel wheel(time, milliseconds(1), log.Handler());
+    WheelTimer cancelled(wheel, milliseconds(10), 1);
+    WheelTimer kept(wheel, milliseconds(10), 2);
+    cancelled.Start();
+    kept.Start();
+    {
+        WheelTimer destroyed(wheel, milliseconds(10), 3);
+        destroyed.Start();
+    }
+    cancelled.Cancel();
+    ASSERT_TRUE(cancelled.IsExpired());
+    ASSERT_EQ(1u, wheel.Size());
+    time.Wait(milliseconds(10));
+    wheel.Advance();
+    ASSERT_EQ(std::vector<std::vector<size_t>>({{2}}), log.batches);
+}
+
+TEST(TimingWheel, RestartFromHandler)
+{
+    FakeTime time;
+    size_t fired = 0;
+    TimingWheel wheel(time, milliseconds(1), [&fired](const std::vector<WheelTimer*>& expired)
+    {
+        for (WheelTimer* timer : expired)
+        {
+            ++fired;
+            timer->Start();
+        }
+    });
+    WheelTimer timer(wheel, milliseconds(10));
+    timer.Start();
+    for (int step = 0; step < 100; ++step)
+    {
+        time.Wait(milliseconds(1));
+        wheel.Advance();
+    }
+    ASSERT_EQ(10u, fired);
+    ASSERT_TRUE(timer.IsScheduled());
+}
+
+TEST(TimingWheel, FarDeadlinesCascade)
+{
+    FakeTime time;
+    ExpiryLog log;
+    TimingWheel wheel(time, milliseconds(1), log.Handler());
+    // One deadline for every level and one beyond the top level
+    const Duration durations[] = {milliseconds(200), milliseconds(60000), hours(3), hours(24 * 100),
+                                  hours(24 * 365 * 3)};
+    std::vector<std::unique_ptr<WheelTimer>> timers;
+    for (size_t i = 0; i < 5; ++i)
+    {
+        timers.emplace_back(new WheelTimer(wheel, durations[i], i));
+        timers.back()->Start();
+    }
+    for (size_t i = 0; i < 5; ++i)
+    {
+        time.Wait(durations[i] - (i == 0 ? s_zeroDuration : durations[i - 1]) - milliseconds(1));
+        ASSERT_EQ(0u, wheel.Advance());
+        time.Wait(milliseconds(1));
+        ASSERT_EQ(1u, wheel.Advance());
+        ASSERT_EQ(i, log.batches.back()[0]);
+    }
+    ASSERT_EQ(0u, wheel.Size());
+}
+
+TEST(TimingWheel, MatchesDeadlines)
+{
+    FakeTime time;
+    const Duration tick = milliseconds(1);
+    const size_t count = 20000;
+    std::vector<TimePoint> deadlines(count);
+    std::vector<bool> pending(count, false);
+    TimePoint lastAdvance = time.GetCurrent();
+    size_t fired = 0;
+    TimingWheel* wheelPointer = nullptr;
+    TimingWheel wheel(time, tick, [&](const std::vector<WheelTimer*>& expired)
+    {
+        for (WheelTimer* timer : expired)
+        {
+            const size_t i = timer->Id();
+            ASSERT_TRUE(pending[i]);
+            pending[i] = false;
+            ++fired;
+            // Not before the deadline, and not when the previous Advance had already reached its tick
+            const TimePoint deadlineTick(tick * ((deadlines[i].time_since_epoch() + tick - Duration(1)) / tick));
+            ASSERT_LE(deadlines[i], wheelPointer->Now());
+            ASSERT_GT(deadlineTick, lastAdvance);
+        }
+    });
+    wheelPointer = &wheel;
+    std::vector<std::unique_ptr<WheelTimer>> timers;
+    uint32_t seed = 7;
+    auto random = [&seed](uint32_t range)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % range;
+    };
+    for (size_t i = 0; i < count; ++i)
+    {
+        timers.emplace_back(new WheelTimer(wheel, milliseconds(random(1 << 20)), i));
+    }
+    for (int step = 0; step < 3000; ++step)
+    {
+        for (int change = 0; change < 20; ++change)
+        {
+            const size_t i = random(count);
+            if (random(4) == 0)
+            {
+                timers[i]->Cancel();
+                pending[i] = false;
+            }
+            else
+            {
+                timers[i]->Start();
+                deadlines[i] = wheel.Now() + timers[i]->TimeLeft();
+                pending[i] = true;
+            }
+        }
+        lastAdvance = wheel.Now();
+        time.Wait(microseconds(random(1000000)));
+        wheel.Advance();
+    }
+    lastAdvance = wheel.Now();
+    time.Wait(hours(1));
+    wheel.Advance();
+    ASSERT_EQ(0u, wheel.Size());
+    ASSERT_EQ(std::vector<bool>(count, false), pending);
+    ASSERT_LT(10000u, fired);
+}
+
+TEST(TimingWheelBenchmark, DISABLED_MillionTimers)
+{
+    FakeTime time;
+    size_t fired = 0;
+    TimingWheel wheel(time, milliseconds(1), [&fired](const std::vector<WheelTimer*>& expired)
+    {
+        fired += expired.size();
+    });
+    const size_t count = 1000000;
+    std::vector<std::unique_ptr<WheelTimer>> timers;
+    uint32_t seed = 3;
+    for (size_t i = 0; i < count; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        timers.emplace_back(new WheelTimer(wheel, milliseconds((seed >> 8) % 600000), i));
+    }
+
+    auto start = steady_clock::now();
+    for (auto& timer : timers)
+    {
+        timer->Start();
+    }
+    auto time1 = duration<double, std::nano>(steady_clock::now() - start).count();
+
+    time.Wait(milliseconds(100));
+    wheel.Advance();
+    start = steady_clock::now();
+    for (auto& timer : timers)
+    {
+        timer->Start();
+    }
+    auto time2 = duration<double, std::nano>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    for (size_t i = 0; i < count; i += 2)
+    {
+        timers[i]->Cancel();
+    }
+    auto time3 = duration<double, std::nano>(steady_clock::now() - start).count();
+
+    size_t advances = 0;
+    start = steady_clock::now();
+    for (; wheel.Size() != 0; ++advances)
+    {
+        time.Wait(milliseconds(1));
+        wheel.Advance();
+    }
+    auto time4 = duration<double, std::nano>(steady_clock::now() - start).count();
+
+    std::cout << "start: " << time1 / count << " ns, restart: " << time2 / count << " ns, cancel: "
+              << time3 / (count / 2) << " ns per timer" << std::endl;
+    std::cout << "expiry: " << fired << " timers in " << advances << " advances, "
+              << time4 / advances << " ns per advance" << std::endl;
+}
+
+TEST(CoarseTime, PublishesOnUpdate)
+{
+    FakeTime source;
+    source.Wait(seconds(1));
+    CoarseTime time(source, s_zeroDuration);
+    ASSERT_EQ(source.GetCurrent(), time.GetCurrent());
+    source.Wait(seconds(2));
+    ASSERT_EQ(source.GetCurrent() - seconds(2), time.GetCurrent());
+    time.Update();
+    ASSERT_EQ(source.GetCurrent(), time.GetCurrent());
+    ASSERT_EQ(source.GetCurrent(), time.Now());
+}
+
+// A clock which can be set anywhere, also back
+class SetTime: public ITime
+{
+public:
+    virtual TimePoint GetCurrent() { return m_current; }
+
+    void Set(TimePoint current) { m_current = current; }
+
+private:
+    TimePoint m_current;
+};
+
+TEST(CoarseTime, NeverGoesBack)
+{
+    SetTime source;
+    source.Set(TimePoint(seconds(5)));
+    CoarseTime time(source, s_zeroDuration);
+    source.Set(TimePoint(seconds(3)));
+    time.Update();
+    ASSERT_EQ(TimePoint(seconds(5)), time.Now());
+    source.Set(TimePoint(seconds(6)));
+    time.Update();
+    ASSERT_EQ(TimePoint(seconds(6)), time.Now());
+}
+
+TEST(CoarseTime, TimerOnCoarseTime)
+{
+    FakeTime source;
+    CoarseTime time(source, s_zeroDuration);
+    Timer timer(time, seconds(5));
+    timer.Start();
+    source.Wait(seconds(2));
+    ASSERT_EQ(seconds(5), timer.TimeLeft());
+    time.Update();
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+    source.Wait(seconds(3));
+    time.Update();
+    ASSERT_TRUE(timer.IsExpired());
+}
+
+TEST(CoarseTime, UpdatesInBackground)
+{
+    SystemTime source;
+    CoarseTime time(source, milliseconds(1));
+    const TimePoint start = time.Now();
+    const TimePoint giveUp = source.GetCurrent() + seconds(10);
+    while (time.Now() == start && source.GetCurrent() < giveUp)
+    {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    ASSERT_LT(start, time.Now());
+}
+
+// Time of one call of read, the sum of the readings keeps the calls from being optimised away
+template <typename Read>
+double NanosecondsPerCall(Read read)
+{
+    const size_t calls = 10000000;
+    Duration::rep sum = 0;
+    const auto start = steady_clock::now();
+    for (size_t call = 0; call < calls; ++call)
+    {
+        sum += read();
+    }
+    const double time = duration<double, std::nano>(steady_clock::now() - start).count();
+    volatile Duration::rep sink = sum;
+    (void)sink;
+    return time / calls;
+}
+
+TEST(CoarseTimeBenchmark, DISABLED_ClockSources)
+{
+    SystemTime system;
+    CoarseTime coarse(system, milliseconds(1));
+    ITime& systemTime = system;
+    ITime& coarseTime = coarse;
+    std::cout << "high_resolution_clock::now: "
+              << NanosecondsPerCall([] { return Clock::now().time_since_epoch().count(); }) << " ns" << std::endl;
+    std::cout << "SystemTime through ITime: "
+              << NanosecondsPerCall([&] { return systemTime.GetCurrent().time_since_epoch().count(); }) << " ns"
+              << std::endl;
+#if defined(__linux__)
+    std::cout << "clock_gettime(CLOCK_MONOTONIC_COARSE): " << NanosecondsPerCall([]
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        return static_cast<Duration::rep>(now.tv_nsec);
+    }) << " ns" << std::endl;
+#endif
+    std::cout << "CoarseTime through ITime: "
+              << NanosecondsPerCall([&] { return coarseTime.GetCurrent().time_since_epoch().count(); }) << " ns"
+              << std::endl;
+    std::cout << "CoarseTime::Now: "
+              << NanosecondsPerCall([&] { return coarse.Now().time_since_epoch().count(); }) << " ns" << std::endl;
+
+    Timer systemTimer(system, hours(1));
+    Timer coarseTimer(coarse, hours(1));
+    systemTimer.Start();
+    coarseTimer.Start();
+    std::cout << "Timer::TimeLeft on SystemTime: "
+              << NanosecondsPerCall([&] { return systemTimer.TimeLeft().count(); }) << " ns" << std::endl;
+    std::cout << "Timer::TimeLeft on CoarseTime: "
+              << NanosecondsPerCall([&] { return coarseTimer.TimeLeft().count(); }) << " ns" << std::endl;
+}
+
+TEST(TimerService, FiresInDeadlineOrder)
+{
+    FakeTime time;
+    TimerService service(time, false);
+    std::vector<int> fired;
+    service.Arm(seconds(3), [&fired] { fired.push_back(3); });
+    service.Arm(seconds(1), [&fired] { fired.push_back(1); });
+    service.Arm(seconds(2), [&fired] { fired.push_back(2); });
+    service.Arm(seconds(1), [&fired] { fired.push_back(4); });
+    ASSERT_EQ(0u, service.Poll());
+    ASSERT_EQ(4u, service.Armed());
+    time.Wait(seconds(2));
+    ASSERT_EQ(3u, service.Poll());
+    time.Wait(seconds(1));
+    ASSERT_EQ(1u, service.Poll());
+    ASSERT_EQ(std::vector<int>({1, 4, 2, 3}), fired);
+}
+
+TEST(TimerService, RearmAndCancel)
+{
+    FakeTime time;
+    TimerService service(time, false);
+    int fired = 0;
+    const TimerService::TimerId moved = service.Arm(seconds(1), [&fired] { fired += 1; },
+                                                    TimerService::TimerMode::Rearmable);
+    const TimerService::TimerId cancelled = service.Arm(seconds(1), [&fired] { fired += 10; },
+                                                        TimerService::TimerMode::Rearmable);
+    service.Rearm(moved, seconds(5));
+    service.Cancel(cancelled);
+    time.Wait(seconds(4));
+    ASSERT_EQ(0u, service.Poll());
+    time.Wait(seconds(1));
+    ASSERT_EQ(1u, service.Poll());
+    ASSERT_EQ(1, fired);
+
+    // A fired timer can be armed again, a cancelled one is gone
+    service.Rearm(moved, seconds(1));
+    service.Rearm(cancelled, seconds(1));
+    time.Wait(seconds(1));
+    ASSERT_EQ(1u, service.Poll());
+    ASSERT_EQ(2, fired);
+    ASSERT_EQ(1u, service.Timers());
+    service.Cancel(moved);
+    service.Poll();
+    ASSERT_EQ(0u, service.Armed());
+    ASSERT_EQ(0u, service.Timers());
+}
+
+TEST(TimerService, OneShotIsReleased)
+{
+    FakeTime time;
+    TimerService service(time, false);
+    int fired = 0;
+    std::vector<TimerService::TimerId> ids;
+    for (int i = 0; i < 1000; ++i)
+    {
+        ids.push_back(service.Arm(seconds(1), [&fired] { ++fired; }));
+    }
+    time.Wait(seconds(1));
+    ASSERT_EQ(1000u, service.Poll());
+    ASSERT_EQ(0u, service.Timers());
+
+    // A fired one-shot timer is gone, the freed slots serve new timers
+    for (TimerService::TimerId id : ids)
+    {
+        service.Rearm(id, seconds(1));
+    }
+    service.Arm(seconds(1), [&fired] { fired += 1000; });
+    time.Wait(seconds(1));
+    ASSERT_EQ(1u, service.Poll());
+    ASSERT_EQ(2000, fired);
+    ASSERT_EQ(0u, service.Timers());
+}
+
+TEST(TimerService, RearmFromCallback)
+{
+    FakeTime time;
+    TimerService service(time, false);
+    int fired = 0;
+    TimerService::TimerId id = 0;
+    id = service.Arm(seconds(1), [&]
+    {
+        ++fired;
+        service.Rearm(id, seconds(1));
+    }, TimerService::TimerMode::Rearmable);
+    for (int second = 0; second < 10; ++second)
+    {
+        time.Wait(seconds(1));
+        service.Poll();
+    }
+    ASSERT_EQ(10, fired);
+}
+
+TEST(TimerService, MatchesSortedDeadlines)
+{
+    FakeTime time;
+    TimerService service(time, false);
+    std::vector<std::pair<Duration, size_t>> expected;
+    std::vector<size_t> fired;
+    uint32_t seed = 11;
+    for (size_t i = 0; i < 5000; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const Duration delay = milliseconds((seed >> 8) % 1000);
+        service.Arm(delay, [&fired, i] { fired.push_back(i); });
+        expected.push_back(std::make_pair(delay, i));
+    }
+    std::sort(expected.begin(), expected.end());
+    for (int step = 0; step < 100; ++step)
+    {
+        time.Wait(milliseconds(10));
+        service.Poll();
+    }
+    ASSERT_EQ(expected.size(), fired.size());
+    for (size_t i = 0; i < fired.size(); ++i)
+    {
+        ASSERT_EQ(expected[i].second, fired[i]);
+    }
+}
+
+TEST(TimerService, ManyProducers)
+{
+    FakeTime time;
+    TimerService service(time, false);
+    std::atomic<size_t> fired(0);
+    std::atomic<size_t> finished(0);
+    const size_t producers = 4;
+    const size_t perProducer = 10000;
+    std::vector<std::thread> threads;
+    for (size_t producer = 0; producer < producers; ++producer)
+    {
+        threads.emplace_back([&service, &fired, &finished]
+        {
+            // The fake time stands still until the producers are done, so nothing fires before its
+            // Cancel or Rearm is applied
+            for (size_t i = 0; i < perProducer; ++i)
+            {
+                const TimerService::TimerId id = service.Arm(milliseconds(1), [&fired] { ++fired; });
+                if (i % 4 == 0)
+                {
+                    service.Cancel(id);
+                }
+                else if (i % 4 == 1)
+                {
+                    service.Rearm(id, milliseconds(1));
+                }
+            }
+            ++finished;
+        });
+    }
+    // The consumer polls while the producers push
+    while (finished < producers)
+    {
+        EXPECT_EQ(0u, service.Poll());
+        std::this_thread::yield();
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    service.Poll();
+    ASSERT_EQ(producers * perProducer * 3 / 4, service.Armed());
+    time.Wait(milliseconds(1));
+    ASSERT_EQ(producers * perProducer * 3 / 4, service.Poll());
+    ASSERT_EQ(producers * perProducer * 3 / 4, fired.load());
+    ASSERT_EQ(0u, service.Timers());
+}
+
+TEST(TimerService, ExpiryThread)
+{
+    SystemTime time;
+    TimerService service(time, true);
+    std::mutex mutex;
+    std::condition_variable done;
+    std::vector<int> fired;
+    auto fire = [&](int timer)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fired.push_back(timer);
+        done.notify_all();
+    };
+    // The thread sleeps for the far timer and has to wake up for the near ones
+    service.Arm(milliseconds(30), [&] { fire(3); });
+    std::this_thread::sleep_for(milliseconds(5));
+    service.Arm(milliseconds(10), [&] { fire(2); });
+    service.Arm(milliseconds(1), [&] { fire(1); });
+    std::unique_lock<std::mutex> lock(mutex);
+    ASSERT_TRUE(done.wait_for(lock, seconds(10), [&] { return fired.size() == 3; }));
+    ASSERT_EQ(std::vector<int>({1, 2, 3}), fired);
+}
+
+TEST(TimerServiceBenchmark, DISABLED_Producers)
+{
+    SystemTime time;
+    for (size_t producers : {1, 2, 4, 8})
+    {
+        TimerService service(time, true);
+        const size_t perProducer = 1000000 / producers;
+        std::atomic<size_t> fired(0);
+        const auto start = steady_clock::now();
+        std::vector<std::thread> threads;
+        for (size_t producer = 0; producer < producers; ++producer)
+        {
+            threads.emplace_back([&]
+            {
+                for (size_t i = 0; i < perProducer; ++i)
+                {
+                    const TimerService::TimerId id = service.Arm(hours(1), [&fired] { ++fired; });
+                    service.Rearm(id, s_zeroDuration);
+                    service.Cancel(id);
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        const double time = duration<double, std::nano>(steady_clock::now() - start).count();
+        std::cout << producers << " producers: " << time / (3 * producers * perProducer) << " ns per command"
+                  << std::endl;
+    }
+}
+
+// A time source policy over a plain time point
+struct ManualTimeSource
+{
+    TimePoint Now() const { return *current; }
+
+    const TimePoint* current;
+};
+
+TEST(BasicTimer, StaticTimeSource)
+{
+    TimePoint current;
+    BasicTimer<ManualTimeSource> timer(ManualTimeSource{&current}, seconds(5));
+    timer.Start();
+    current += seconds(2);
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+    current += seconds(3);
+    ASSERT_TRUE(timer.IsExpired());
+    ASSERT_EQ(seconds(0), timer.TimeLeft());
+}
+
+TEST(BasicTimer, SystemTimer)
+{
+    SystemTimer timer(hours(1));
+    timer.Start();
+    ASSERT_FALSE(timer.IsExpired());
+    ASSERT_LT(minutes(59), timer.TimeLeft());
+
+    SystemTimer expired(s_zeroDuration);
+    expired.Start();
+    ASSERT_TRUE(expired.IsExpired());
+}
+
+TEST(BasicTimer, CoarseTimer)
+{
+    FakeTime source;
+    CoarseTime time(source, s_zeroDuration);
+    CoarseTimer timer(time, seconds(5));
+    timer.Start();
+    source.Wait(seconds(2));
+    time.Update();
+    ASSERT_EQ(seconds(3), timer.TimeLeft());
+}
+
+TEST(BasicTimer, UsableAsITimer)
+{
+    FakeTime time;
+    Timer injected(time, seconds(1));
+    SystemTimer system(seconds(1));
+    ITimer* timers[] = {&injected, &system};
+    for (ITimer* timer : timers)
+    {
+        ASSERT_EQ(seconds(0), timer->TimeLeft());
+        timer->Start();
+        ASSERT_FALSE(timer->IsExpired());
+    }
+}
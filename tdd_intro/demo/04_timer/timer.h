@@ -0,0 +1,114 @@
+#pragma once
+#include <chrono>
+
+/*
+ * Timer interfaces shared by the timer implementations of this demo.
+ *
+ * ITime is the injected clock: SystemTime in production, tests advance FakeTime by hand.
+ * BasicTimer is a single polled deadline: every query reads the clock once. Its time source is a template
+ * parameter, so with a clock known at compile time (SystemTimer) a query is an inlined now() and a subtraction,
+ * and BasicTimer is final, so calls on a concrete timer need no virtual dispatch either.
+ * Timer is the instantiation over ITime, which keeps the clock injectable.
+*/
+
+typedef std::chrono::high_resolution_clock Clock;
+typedef Clock::duration Duration;
+typedef std::chrono::time_point<Clock> TimePoint;
+static const Duration s_zeroDuration(std::chrono::microseconds(0));
+
+class ITimer {
+public:
+  virtual ~ITimer() {}
+
+  virtual void Start() = 0;
+  virtual bool IsExpired() const = 0;
+  virtual Duration TimeLeft() const = 0;
+};
+
+class ITime
+{
+public:
+    virtual ~ITime() { }
+
+    virtual TimePoint GetCurrent() = 0;
+};
+
+class SystemTime: public ITime
+{
+public:
+    virtual TimePoint GetCurrent() override { return Clock::now(); }
+};
+
+// Time source policies of BasicTimer: copyable handles with a non-virtual TimePoint Now() const
+
+// The system clock, known at compile time
+struct SystemTimeSource
+{
+    TimePoint Now() const { return Clock::now(); }
+};
+
+// Any ITime, one virtual call per read
+class ITimeSource
+{
+public:
+    ITimeSource(ITime& time) : m_time(&time) { }
+
+    TimePoint Now() const { return m_time->GetCurrent(); }
+
+private:
+    ITime* m_time;
+};
+
+template <typename TimeSource>
+class BasicTimer final: public ITimer
+{
+public:
+    BasicTimer(TimeSource source, Duration duration)
+        : m_source(source), m_duration(duration), m_started(false)
+    { }
+
+    explicit BasicTimer(Duration duration)
+        : BasicTimer(TimeSource(), duration)
+    { }
+
+    virtual void Start() override
+    {
+        m_started = true;
+        m_startTime = m_source.Now();
+    }
+
+    virtual bool IsExpired() const override
+    {
+        return TimeElapsed() >= m_duration;
+    }
+
+    virtual Duration TimeLeft() const override
+    {
+        const Duration elapsed = TimeElapsed();
+        if (m_started && elapsed < m_duration)
+        {
+            return m_duration - elapsed;
+        }
+        return s_zeroDuration;
+    }
+
+private:
+    Duration TimeElapsed() const
+    {
+        if (m_started)
+        {
+            return m_source.Now() - m_startTime;
+        }
+        return s_zeroDuration;
+    }
+
+private:
+    TimeSource m_source;
+    Duration m_duration;
+    bool m_started;
+    TimePoint m_startTime;
+};
+
+// Timer(ITime&, Duration) for injected clocks
+typedef BasicTimer<ITimeSource> Timer;
+typedef BasicTimer<SystemTimeSource> SystemTimer;
@@ -0,0 +1,336 @@
+#include "timerservice.h"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+    const size_t s_arity = 4;
+}
+
+const Duration TimerService::s_maxSleep = std::chrono::milliseconds(100);
+
+TimerService::TimerService(ITime& time, bool expiryThread)
+    : m_time(time)
+    , m_nextId(1)
+    , m_head(&m_stub)
+    , m_tail(&m_stub)
+    , m_sequence(0)
+    , m_sleeping(false)
+    , m_stop(false)
+{
+    m_stub.next.store(nullptr, std::memory_order_relaxed);
+    if (expiryThread)
+    {
+        m_thread = std::thread(&TimerService::Run, this);
+    }
+}
+
+TimerService::~TimerService()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wakeUp.notify_all();
+        m_thread.join();
+    }
+    while (Command* command = Pop())
+    {
+        delete command;
+    }
+}
+
+TimerService::TimerId TimerService::Arm(Duration delay, Callback callback, TimerMode mode)
+{
+    Command* command = new Command;
+    command->kind = CommandKind::Arm;
+    command->id = m_nextId.fetch_add(1, std::memory_order_relaxed);
+    command->deadline = m_time.GetCurrent() + std::max(delay, s_zeroDuration);
+    command->callback = std::move(callback);
+    command->mode = mode;
+    const TimerId id = command->id;
+    Push(command);
+    return id;
+}
+
+void TimerService::Rearm(TimerId id, Duration delay)
+{
+    Command* command = new Command;
+    command->kind = CommandKind::Rearm;
+    command->id = id;
+    command->deadline = m_time.GetCurrent() + std::max(delay, s_zeroDuration);
+    Push(command);
+}
+
+void TimerService::Cancel(TimerId id)
+{
+    Command* command = new Command;
+    command->kind = CommandKind::Cancel;
+    command->id = id;
+    Push(command);
+}
+
+size_t TimerService::Poll()
+{
+    while (Command* command = Pop())
+    {
+        Apply(*command);
+        delete command;
+    }
+
+    const TimePoint now = m_time.GetCurrent();
+    size_t fired = 0;
+    while (!m_heap.empty() && m_heap[0].deadline <= now)
+    {
+        const uint32_t slot = m_heap[0].slot;
+        RemoveFromHeap(0);
+        // Commands of the callback wait in the queue, so the slot stays as it is during the call
+        m_slots[slot].callback();
+        if (m_slots[slot].mode == TimerMode::OneShot)
+        {
+            Release(slot);
+        }
+        ++fired;
+    }
+    return fired;
+}
+
+size_t TimerService::Armed() const
+{
+    return m_heap.size();
+}
+
+size_t TimerService::Timers() const
+{
+    return m_slotOfId.size();
+}
+
+void TimerService::Push(Command* command)
+{
+    command->next.store(nullptr, std::memory_order_relaxed);
+    Command* previous = m_head.exchange(command, std::memory_order_seq_cst);
+    previous->next.store(command, std::memory_order_release);
+    if (m_sleeping.load(std::memory_order_seq_cst))
+    {
+        Wake();
+    }
+}
+
+TimerService::Command* TimerService::Pop()
+{
+    Command* tail = m_tail;
+    Command* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &m_stub)
+    {
+        if (next == nullptr)
+        {
+            return nullptr;
+        }
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next != nullptr)
+    {
+        m_tail = next;
+        return tail;
+    }
+    if (tail != m_head.load(std::memory_order_acquire))
+    {
+        // A producer has taken the head but not linked its command yet, the next Poll gets it
+        return nullptr;
+    }
+    // tail is the last command, the stub goes behind it so that tail can be handed out
+    m_stub.next.store(nullptr, std::memory_order_relaxed);
+    Command* previous = m_head.exchange(&m_stub, std::memory_order_seq_cst);
+    previous->next.store(&m_stub, std::memory_order_release);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void TimerService::Apply(Command& command)
+{
+    auto found = m_slotOfId.find(command.id);
+    switch (command.kind)
+    {
+    case CommandKind::Arm:
+    {
+        uint32_t slot;
+        if (m_freeSlots.empty())
+        {
+            slot = static_cast<uint32_t>(m_slots.size());
+            m_slots.push_back(Slot());
+        }
+        else
+        {
+            slot = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+        m_slots[slot].callback = std::move(command.callback);
+        m_slots[slot].id = command.id;
+        m_slots[slot].mode = command.mode;
+        m_slots[slot].heapIndex = s_notArmed;
+        m_slotOfId.emplace(command.id, slot);
+        Schedule(slot, command.deadline);
+        break;
+    }
+    case CommandKind::Rearm:
+        if (found != m_slotOfId.end())
+        {
+            Schedule(found->second, command.deadline);
+        }
+        break;
+    case CommandKind::Cancel:
+        if (found != m_slotOfId.end())
+        {
+            Release(found->second);
+        }
+        break;
+    }
+}
+
+void TimerService::Schedule(uint32_t slot, TimePoint deadline)
+{
+    const HeapEntry entry = {deadline, m_sequence++, slot};
+    const size_t index = m_slots[slot].heapIndex;
+    if (index == s_notArmed)
+    {
+        m_heap.push_back(entry);
+        SiftUp(m_heap.size() - 1, entry);
+    }
+    else if (Earlier(entry, m_heap[index]))
+    {
+        SiftUp(index, entry);
+    }
+    else
+    {
+        SiftDown(index, entry);
+    }
+}
+
+void TimerService::Release(uint32_t slot)
+{
+    if (m_slots[slot].heapIndex != s_notArmed)
+    {
+        RemoveFromHeap(m_slots[slot].heapIndex);
+    }
+    m_slots[slot].callback = nullptr;
+    m_slotOfId.erase(m_slots[slot].id);
+    m_freeSlots.push_back(slot);
+}
+
+bool TimerService::Earlier(const HeapEntry& left, const HeapEntry& right)
+{
+    return left.deadline < right.deadline || (left.deadline == right.deadline && left.sequence < right.sequence);
+}
+
+void TimerService::Place(size_t index, const HeapEntry& entry)
+{
+    m_heap[index] = entry;
+    m_slots[entry.slot].heapIndex = index;
+}
+
+void TimerService::SiftUp(size_t index, HeapEntry entry)
+{
+    while (index > 0)
+    {
+        const size_t parent = (index - 1) / s_arity;
+        if (!Earlier(entry, m_heap[parent]))
+        {
+            break;
+        }
+        Place(index, m_heap[parent]);
+        index = parent;
+    }
+    Place(index, entry);
+}
+
+void TimerService::SiftDown(size_t index, HeapEntry entry)
+{
+    const size_t size = m_heap.size();
+    for (;;)
+    {
+        const size_t first = index * s_arity + 1;
+        if (first >= size)
+        {
+            break;
+        }
+        const size_t last = std::min(first + s_arity, size);
+        size_t earliest = first;
+        for (size_t child = first + 1; child < last; ++child)
+        {
+            if (Earlier(m_heap[child], m_heap[earliest]))
+            {
+                earliest = child;
+            }
+        }
+        if (!Earlier(m_heap[earliest], entry))
+        {
+            break;
+        }
+        Place(index, m_heap[earliest]);
+        index = earliest;
+    }
+    Place(index, entry);
+}
+
+void TimerService::RemoveFromHeap(size_t index)
+{
+    m_slots[m_heap[index].slot].heapIndex = s_notArmed;
+    const HeapEntry last = m_heap.back();
+    m_heap.pop_back();
+    if (index == m_heap.size())
+    {
+        return;
+    }
+    if (index > 0 && Earlier(last, m_heap[(index - 1) / s_arity]))
+    {
+        SiftUp(index, last);
+    }
+    else
+    {
+        SiftDown(index, last);
+    }
+}
+
+void TimerService::Run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        lock.unlock();
+        Poll();
+        lock.lock();
+
+        Duration sleep = s_maxSleep;
+        if (!m_heap.empty())
+        {
+            sleep = std::min(sleep, m_heap[0].deadline - m_time.GetCurrent());
+        }
+        if (m_stop || sleep <= s_zeroDuration)
+        {
+            continue;
+        }
+        // A producer which pushes after this store sees it and wakes the thread through the mutex
+        m_sleeping.store(true, std::memory_order_seq_cst);
+        // Only the stub in the queue: it is empty and no push has started
+        if (m_tail == &m_stub && m_head.load(std::memory_order_seq_cst) == &m_stub)
+        {
+            m_wakeUp.wait_for(lock, sleep);
+        }
+        m_sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void TimerService::Wake()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wakeUp.notify_one();
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "timer.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Timer service for many threads: any thread arms, re-arms and cancels timers, one thread fires them.
+ *
+ * Arm, Rearm and Cancel compute the deadline from ITime and push a command into a lock-free multi-producer
+ * single-consumer queue (an intrusive Vyukov queue: a push is one atomic exchange), so producers never wait
+ * for each other or for the expiry thread. Timer ids come from an atomic counter.
+ * Only the consumer touches the timers: Poll applies the queued commands in push order to a 4-ary min-heap
+ * of deadlines, then calls the callbacks of all due timers in deadline order, arming order on equal deadlines.
+ * A 4-ary heap is half as deep as a binary one and the children of a node are next to each other in memory.
+ *
+ * With an expiry thread the service polls by itself and sleeps until the next deadline; a producer wakes it
+ * only when it is asleep. Without one the owner calls Poll, which keeps tests on a FakeTime deterministic.
+ * Callbacks run on the polling thread, they may arm, re-arm and cancel timers but not poll.
+ *
+ * A one-shot timer is released when it fires, so millions of timeouts leave nothing behind. A rearmable timer
+ * lives until it is cancelled: once fired it waits for a Rearm, from its callback or from any thread.
+ * Commands for released, cancelled or unknown ids are ignored.
+*/
+
+class TimerService
+{
+public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    enum class TimerMode
+    {
+        OneShot,
+        Rearmable
+    };
+
+    // The expiry thread sleeps at most s_maxSleep, so a clock which jumps is noticed in time
+    static const Duration s_maxSleep;
+
+    TimerService(ITime& time, bool expiryThread);
+    ~TimerService();
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    // Thread-safe and lock-free
+    TimerId Arm(Duration delay, Callback callback, TimerMode mode = TimerMode::OneShot);
+    void Rearm(TimerId id, Duration delay);
+    void Cancel(TimerId id);
+
+    // Consumer only: applies the queued commands, fires the due timers and returns how many fired
+    size_t Poll();
+    // Consumer only: number of armed timers after the last Poll
+    size_t Armed() const;
+    // Consumer only: number of timers which are armed or wait for a Rearm after the last Poll
+    size_t Timers() const;
+
+private:
+    enum class CommandKind
+    {
+        Arm,
+        Rearm,
+        Cancel
+    };
+
+    struct Command
+    {
+        std::atomic<Command*> next;
+        CommandKind kind;
+        TimerId id;
+        TimePoint deadline;
+        Callback callback;
+        TimerMode mode;
+    };
+
+    struct HeapEntry
+    {
+        TimePoint deadline;
+        uint64_t sequence;
+        uint32_t slot;
+    };
+
+    struct Slot
+    {
+        Callback callback;
+        TimerId id;
+        TimerMode mode;
+        // Position in the heap, s_notArmed when the timer waits for a re-arm
+        size_t heapIndex;
+    };
+
+    static const size_t s_notArmed = SIZE_MAX;
+
+    void Push(Command* command);
+    Command* Pop();
+    void Apply(Command& command);
+    void Schedule(uint32_t slot, TimePoint deadline);
+    // Frees the slot and forgets its id
+    void Release(uint32_t slot);
+
+    static bool Earlier(const HeapEntry& left, const HeapEntry& right);
+    void Place(size_t index, const HeapEntry& entry);
+    void SiftUp(size_t index, HeapEntry entry);
+    void SiftDown(size_t index, HeapEntry entry);
+    void RemoveFromHeap(size_t index);
+
+    void Run();
+    void Wake();
+
+    ITime& m_time;
+    std::atomic<TimerId> m_nextId;
+
+    // Producers exchange m_head, the consumer follows m_tail
+    std::atomic<Command*> m_head;
+    Command* m_tail;
+    Command m_stub;
+
+    std::vector<HeapEntry> m_heap;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_freeSlots;
+    std::unordered_map<TimerId, uint32_t> m_slotOfId;
+    uint64_t m_sequence;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::atomic<bool> m_sleeping;
+    bool m_stop;
+    std::thread m_thread;
+};
@@ -0,0 +1,279 @@
+#include "timingwheel.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    using wheel_detail::Link;
+
+    const uint64_t s_slotMask = TimingWheel::s_slotCount - 1;
+    // Ticks the top level reaches
+    const uint64_t s_maxDelta = (uint64_t(1) << (TimingWheel::s_levelBits * TimingWheel::s_levelCount)) - 1;
+
+    void LinkBefore(Link& head, Link& link)
+    {
+        link.prev = head.prev;
+        link.next = &head;
+        head.prev->next = &link;
+        head.prev = &link;
+    }
+
+    void Unlink(Link& link)
+    {
+        link.prev->next = link.next;
+        link.next->prev = link.prev;
+        link.prev = nullptr;
+        link.next = nullptr;
+    }
+}
+
+TimingWheel::TimingWheel(ITime& time, Duration tick, ExpiryHandler handler)
+    : m_time(time)
+    , m_tick(tick)
+    , m_handler(std::move(handler))
+    , m_origin(time.GetCurrent())
+    , m_now(m_origin)
+    , m_nextTick(0)
+    , m_size(0)
+    , m_levelSizes()
+{
+    if (tick <= s_zeroDuration)
+    {
+        throw std::invalid_argument("Timing wheel tick must be positive");
+    }
+    for (auto& level : m_slots)
+    {
+        for (Link& slot : level)
+        {
+            slot.prev = &slot;
+            slot.next = &slot;
+        }
+    }
+}
+
+TimingWheel::~TimingWheel()
+{
+    for (auto& level : m_slots)
+    {
+        for (Link& slot : level)
+        {
+            while (slot.next != &slot)
+            {
+                Unlink(*slot.next);
+            }
+        }
+    }
+}
+
+size_t TimingWheel::Advance()
+{
+    const TimePoint now = m_time.GetCurrent();
+    m_now = std::max(m_now, now);
+    // Every tick up to target has fully passed
+    const uint64_t target = (m_now - m_origin) / m_tick;
+    m_expired.clear();
+    while (m_nextTick <= target)
+    {
+        const uint64_t busy = NextBusyTick();
+        if (busy > m_nextTick)
+        {
+            m_nextTick = std::min(busy, target + 1);
+            continue;
+        }
+        for (size_t level = 1; level < s_levelCount; ++level)
+        {
+            if (((m_nextTick >> (s_levelBits * (level - 1))) & s_slotMask) != 0)
+            {
+                break;
+            }
+            Cascade(level);
+        }
+        Expire(m_expired);
+        ++m_nextTick;
+    }
+    if (m_expired.empty())
+    {
+        return 0;
+    }
+    // The handler may start timers or advance the wheel again, so it gets its own batch
+    std::vector<WheelTimer*> batch;
+    batch.swap(m_expired);
+    m_handler(batch);
+    const size_t count = batch.size();
+    if (m_expired.empty())
+    {
+        batch.clear();
+        m_expired.swap(batch);
+    }
+    return count;
+}
+
+TimePoint TimingWheel::Now() const
+{
+    return m_now;
+}
+
+Duration TimingWheel::Tick() const
+{
+    return m_tick;
+}
+
+size_t TimingWheel::Size() const
+{
+    return m_size;
+}
+
+void TimingWheel::Schedule(WheelTimer& timer)
+{
+    if (timer.IsScheduled())
+    {
+        Unschedule(timer);
+    }
+    timer.m_deadline = m_now + std::max(timer.m_duration, s_zeroDuration);
+    timer.m_deadlineTick = DeadlineTick(timer.m_deadline);
+    Insert(timer);
+    ++m_size;
+}
+
+void TimingWheel::Unschedule(WheelTimer& timer)
+{
+    Remove(timer);
+    --m_size;
+}
+
+void TimingWheel::Insert(WheelTimer& timer)
+{
+    // Overdue timers fire with the next tick, deadlines beyond the top level wait in its farthest slot
+    const uint64_t delta = std::min(std::max(timer.m_deadlineTick, m_nextTick) - m_nextTick, s_maxDelta);
+    const uint64_t tick = m_nextTick + delta;
+    size_t level = 0;
+    while (level + 1 < s_levelCount && delta >> (s_levelBits * (level + 1)) != 0)
+    {
+        ++level;
+    }
+    LinkBefore(m_slots[level][(tick >> (s_levelBits * level)) & s_slotMask], timer);
+    timer.m_level = level;
+    ++m_levelSizes[level];
+}
+
+void TimingWheel::Remove(WheelTimer& timer)
+{
+    Unlink(timer);
+    --m_levelSizes[timer.m_level];
+}
+
+void TimingWheel::Cascade(size_t level)
+{
+    Link& slot = m_slots[level][(m_nextTick >> (s_levelBits * level)) & s_slotMask];
+    // Take the whole list first, a timer of a far deadline can go back into the same slot
+    Link pending;
+    pending.prev = &pending;
+    pending.next = &pending;
+    if (slot.next != &slot)
+    {
+        pending.next = slot.next;
+        pending.prev = slot.prev;
+        pending.next->prev = &pending;
+        pending.prev->next = &pending;
+        slot.prev = &slot;
+        slot.next = &slot;
+    }
+    while (pending.next != &pending)
+    {
+        WheelTimer& timer = static_cast<WheelTimer&>(*pending.next);
+        Remove(timer);
+        Insert(timer);
+    }
+}
+
+void TimingWheel::Expire(std::vector<WheelTimer*>& expired)
+{
+    Link& slot = m_slots[0][m_nextTick & s_slotMask];
+    while (slot.next != &slot)
+    {
+        WheelTimer& timer = static_cast<WheelTimer&>(*slot.next);
+        Unschedule(timer);
+        expired.push_back(&timer);
+    }
+}
+
+uint64_t TimingWheel::NextBusyTick() const
+{
+    if (m_size == 0)
+    {
+        return UINT64_MAX;
+    }
+    size_t level = 0;
+    while (m_levelSizes[level] == 0)
+    {
+        ++level;
+    }
+    if (level == 0)
+    {
+        return m_nextTick;
+    }
+    // The next cascade of the lowest busy level, every lower slot before it is empty
+    const size_t bits = s_levelBits * level;
+    return ((m_nextTick + (uint64_t(1) << bits) - 1) >> bits) << bits;
+}
+
+uint64_t TimingWheel::DeadlineTick(TimePoint deadline) const
+{
+    if (deadline <= m_origin)
+    {
+        return 0;
+    }
+    return (deadline - m_origin + m_tick - Duration(1)) / m_tick;
+}
+
+WheelTimer::WheelTimer(TimingWheel& wheel, Duration duration, size_t id)
+    : Link{nullptr, nullptr}
+    , m_wheel(wheel)
+    , m_duration(duration)
+    , m_id(id)
+    , m_deadlineTick(0)
+    , m_level(0)
+{
+}
+
+WheelTimer::~WheelTimer()
+{
+    Cancel();
+}
+
+void WheelTimer::Start()
+{
+    m_wheel.Schedule(*this);
+}
+
+bool WheelTimer::IsExpired() const
+{
+    return !IsScheduled() || m_deadline <= m_wheel.m_now;
+}
+
+Duration WheelTimer::TimeLeft() const
+{
+    if (IsScheduled() && m_deadline > m_wheel.m_now)
+    {
+        return m_deadline - m_wheel.m_now;
+    }
+    return s_zeroDuration;
+}
+
+void WheelTimer::Cancel()
+{
+    if (IsScheduled())
+    {
+        m_wheel.Unschedule(*this);
+    }
+}
+
+bool WheelTimer::IsScheduled() const
+{
+    return next != nullptr;
+}
+
+size_t WheelTimer::Id() const
+{
+    return m_id;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "timer.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/*
+ * Hierarchical timing wheel for many concurrent timeouts.
+ *
+ * Time is cut into ticks counted from the construction of the wheel. A deadline is rounded up to whole ticks.
+ * The wheel has s_levelCount levels of s_slotCount slots, each slot an intrusive list of timers:
+ * level 0 holds the timers of the next 256 ticks one slot per tick, level 1 the following 256 * 256 ticks
+ * 256 ticks per slot and so on. When the tick counter crosses a slot boundary of an upper level, the timers of
+ * that slot are moved one level down (cascaded), so every timer moves at most s_levelCount - 1 times.
+ * Deadlines beyond the top level wait in its farthest slot and are put back when it is cascaded.
+ * Runs of ticks with nothing to do are skipped: while the lower levels are empty the wheel jumps to the next
+ * slot boundary of the lowest level which holds timers, so an idle or sparse wheel catches up in a few steps.
+ * Start, restart and cancel are a list unlink and link: O(1) and no allocation.
+ *
+ * Advance reads the clock once and processes all ticks up to it. The timers which expire in one Advance are
+ * passed to the expiry handler together, in deadline tick order. The handler may start, restart or cancel
+ * any timer, the wheel does not touch the batch after handing it out.
+ * WheelTimer answers IsExpired and TimeLeft from the time of the last Advance, so queries never read the clock.
+ *
+ * Not thread-safe. Destroying the wheel cancels all timers, they may be destroyed later but not used.
+*/
+
+class WheelTimer;
+
+namespace wheel_detail
+{
+    // Element of a circular doubly linked list, unlinked when both pointers are null
+    struct Link
+    {
+        Link* prev;
+        Link* next;
+    };
+}
+
+class TimingWheel
+{
+public:
+    static const size_t s_levelBits = 8;
+    static const size_t s_slotCount = 1 << s_levelBits;
+    static const size_t s_levelCount = 4;
+
+    using ExpiryHandler = std::function<void(const std::vector<WheelTimer*>& expired)>;
+
+    // Throws std::invalid_argument when tick is not positive
+    TimingWheel(ITime& time, Duration tick, ExpiryHandler handler);
+    ~TimingWheel();
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    // Reads the clock, moves the wheel to it and hands all expired timers to the handler in one batch.
+    // Returns the number of expired timers.
+    size_t Advance();
+
+    // Time of the last Advance, or of the construction
+    TimePoint Now() const;
+    Duration Tick() const;
+    // Number of scheduled timers
+    size_t Size() const;
+
+private:
+    friend class WheelTimer;
+
+    void Schedule(WheelTimer& timer);
+    void Unschedule(WheelTimer& timer);
+    void Insert(WheelTimer& timer);
+    void Remove(WheelTimer& timer);
+    void Cascade(size_t level);
+    void Expire(std::vector<WheelTimer*>& expired);
+    // First tick after m_nextTick at which a cascade or expiry can happen, ticks before it are empty
+    uint64_t NextBusyTick() const;
+    uint64_t DeadlineTick(TimePoint deadline) const;
+
+    ITime& m_time;
+    Duration m_tick;
+    ExpiryHandler m_handler;
+    TimePoint m_origin;
+    TimePoint m_now;
+    // Next tick to process, every tick before it has fired
+    uint64_t m_nextTick;
+    size_t m_size;
+    wheel_detail::Link m_slots[s_levelCount][s_slotCount];
+    size_t m_levelSizes[s_levelCount];
+    std::vector<WheelTimer*> m_expired;
+};
+
+// ITimer whose deadline is kept by a TimingWheel
+class WheelTimer : public ITimer, private wheel_detail::Link
+{
+public:
+    // id is not used by the wheel, it lets the expiry handler find what the timer belongs to
+    WheelTimer(TimingWheel& wheel, Duration duration, size_t id = 0);
+    ~WheelTimer();
+    WheelTimer(const WheelTimer&) = delete;
+    WheelTimer& operator=(const WheelTimer&) = delete;
+
+    // Starts or restarts the timer from the time of the last Advance
+    virtual void Start() override;
+    virtual bool IsExpired() const override;
+    virtual Duration TimeLeft() const override;
+
+    // A cancelled timer is expired like a timer which was never started, its handler is not called
+    void Cancel();
+    bool IsScheduled() const;
+    size_t Id() const;
+
+private:
+    friend class TimingWheel;
+
+    TimingWheel& m_wheel;
+    Duration m_duration;
+    size_t m_id;
+    TimePoint m_deadline;
+    uint64_t m_deadlineTick;
+    size_t m_level;
+};
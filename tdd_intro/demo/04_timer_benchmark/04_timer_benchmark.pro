@@ -0,0 +1,22 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG -= qt
+CONFIG += thread
+
+DEFINES += NOMINMAX
+
+TIMER_DIR = $$PWD/../04_timer
+INCLUDEPATH += $$TIMER_DIR
+
+SOURCES += \
+    main.cpp \
+    $$TIMER_DIR/coarsetime.cpp \
+    $$TIMER_DIR/timerservice.cpp \
+    $$TIMER_DIR/timingwheel.cpp
+
+HEADERS += \
+    $$TIMER_DIR/coarsetime.h \
+    $$TIMER_DIR/timer.h \
+    $$TIMER_DIR/timerservice.h \
+    $$TIMER_DIR/timingwheel.h
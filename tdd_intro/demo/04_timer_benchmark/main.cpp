@@ -0,0 +1,284 @@
+/*
+ * Timer benchmarks with machine-readable results.
+ *
+ * Architecture:
+ * Call cost: ns per Timer::IsExpired and Timer::TimeLeft on every clock, through the virtual ITime
+ *   and through a time source known at compile time (BasicTimer), which the compiler can inline.
+ * Dispatch jitter: 10^3 to 10^6 active timers with deadlines spread over one second, fired by
+ *   TimerService on its expiry thread and by a TimingWheel advanced in a loop. The lateness of every
+ *   callback against its deadline gives the p50, p99 and p999 percentiles.
+ * Results are one JSON document on standard output, or in the file given as the first argument,
+ *   so regression tracking can compare runs.
+ *
+ * Usage: 04_timer_benchmark [result.json] [--quick]
+ *   --quick stops at 10^4 timers.
+*/
+
+#include "coarsetime.h"
+#include "timer.h"
+#include "timerservice.h"
+#include "timingwheel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+namespace
+{
+    class FakeTime: public ITime
+    {
+    public:
+        virtual TimePoint GetCurrent() override { return m_current; }
+
+        void Wait(Duration duration) { m_current += duration; }
+
+    private:
+        TimePoint m_current;
+    };
+
+    // Time source of a fake clock for BasicTimer, volatile so that the reads are not hoisted out of the
+    // measured loop once inlined
+    struct FakeTimeSource
+    {
+        TimePoint Now() const { return TimePoint(Duration(*current)); }
+
+        const volatile Duration::rep* current;
+    };
+
+    // One JSON object per result, fields in insertion order
+    class JsonObject
+    {
+    public:
+        JsonObject& Add(const std::string& name, const std::string& value)
+        {
+            Key(name) << '"' << value << '"';
+            return *this;
+        }
+
+        JsonObject& Add(const std::string& name, double value)
+        {
+            Key(name) << value;
+            return *this;
+        }
+
+        JsonObject& Add(const std::string& name, size_t value)
+        {
+            Key(name) << value;
+            return *this;
+        }
+
+        std::string Text() const
+        {
+            return "{" + m_fields.str() + "}";
+        }
+
+    private:
+        std::ostringstream& Key(const std::string& name)
+        {
+            if (!m_fields.str().empty())
+            {
+                m_fields << ", ";
+            }
+            m_fields << '"' << name << "\": ";
+            return m_fields;
+        }
+
+        std::ostringstream m_fields;
+    };
+
+    // Time of one call of query, the sum of the results keeps the calls from being optimised away
+    template <typename Query>
+    double NanosecondsPerCall(Query query)
+    {
+        const size_t calls = 10000000;
+        uint64_t sum = 0;
+        const auto start = steady_clock::now();
+        for (size_t call = 0; call < calls; ++call)
+        {
+            sum += static_cast<uint64_t>(query());
+        }
+        const double time = duration<double, std::nano>(steady_clock::now() - start).count();
+        volatile uint64_t sink = sum;
+        (void)sink;
+        return time / calls;
+    }
+
+    template <typename AnyTimer>
+    void AddCallCosts(std::vector<std::string>& results, const std::string& clock, const std::string& dispatch,
+                      AnyTimer& timer)
+    {
+        timer.Start();
+        results.push_back(JsonObject().Add("benchmark", "Timer.IsExpired").Add("clock", clock)
+                              .Add("dispatch", dispatch)
+                              .Add("ns_per_call", NanosecondsPerCall([&] { return timer.IsExpired() ? 1 : 0; }))
+                              .Text());
+        results.push_back(JsonObject().Add("benchmark", "Timer.TimeLeft").Add("clock", clock)
+                              .Add("dispatch", dispatch)
+                              .Add("ns_per_call", NanosecondsPerCall([&] { return timer.TimeLeft().count(); }))
+                              .Text());
+    }
+
+    void CallCosts(std::vector<std::string>& results)
+    {
+        const Duration duration = hours(1);
+        SystemTime system;
+        CoarseTime coarse(system, milliseconds(1));
+        FakeTime fake;
+        Timer systemTimer(system, duration);
+        Timer coarseTimer(coarse, duration);
+        Timer fakeTimer(fake, duration);
+        AddCallCosts(results, "system", "virtual", systemTimer);
+        AddCallCosts(results, "coarse", "virtual", coarseTimer);
+        AddCallCosts(results, "fake", "virtual", fakeTimer);
+
+        volatile Duration::rep fakeTime = 0;
+        SystemTimer staticSystemTimer(duration);
+        CoarseTimer staticCoarseTimer(coarse, duration);
+        BasicTimer<FakeTimeSource> staticFakeTimer(FakeTimeSource{&fakeTime}, duration);
+        AddCallCosts(results, "system", "static", staticSystemTimer);
+        AddCallCosts(results, "coarse", "static", staticCoarseTimer);
+        AddCallCosts(results, "fake", "static", staticFakeTimer);
+    }
+
+    // Deadlines of count timers spread evenly over one second, starting after all of them are armed
+    std::vector<TimePoint> Deadlines(size_t count, TimePoint now)
+    {
+        const TimePoint first = now + milliseconds(500) + microseconds(2 * count);
+        std::vector<TimePoint> deadlines(count);
+        uint32_t seed = 1;
+        for (TimePoint& deadline : deadlines)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            deadline = first + microseconds((seed >> 8) % 1000000);
+        }
+        return deadlines;
+    }
+
+    void AddJitter(std::vector<std::string>& results, const std::string& benchmark, std::vector<double>& lateness)
+    {
+        auto percentile = [&lateness](double fraction)
+        {
+            const size_t index = std::min(lateness.size() - 1, static_cast<size_t>(fraction * lateness.size()));
+            std::nth_element(lateness.begin(), lateness.begin() + index, lateness.end());
+            return lateness[index];
+        };
+        results.push_back(JsonObject().Add("benchmark", benchmark)
+                              .Add("timers", lateness.size())
+                              .Add("p50_us", percentile(0.5))
+                              .Add("p99_us", percentile(0.99))
+                              .Add("p999_us", percentile(0.999))
+                              .Add("max_us", *std::max_element(lateness.begin(), lateness.end()))
+                              .Text());
+    }
+
+    void ServiceJitter(std::vector<std::string>& results, size_t count)
+    {
+        SystemTime time;
+        const std::vector<TimePoint> deadlines = Deadlines(count, time.GetCurrent());
+        std::vector<double> lateness(count);
+        std::atomic<size_t> fired(0);
+        {
+            TimerService service(time, true);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const TimePoint deadline = deadlines[i];
+                double* late = &lateness[i];
+                service.Arm(deadline - time.GetCurrent(), [deadline, late, &fired]
+                {
+                    *late = duration<double, std::micro>(Clock::now() - deadline).count();
+                    fired.fetch_add(1, std::memory_order_release);
+                });
+            }
+            while (fired.load(std::memory_order_acquire) != count)
+            {
+                std::this_thread::sleep_for(milliseconds(10));
+            }
+        }
+        AddJitter(results, "TimerService.dispatch", lateness);
+    }
+
+    void WheelJitter(std::vector<std::string>& results, size_t count)
+    {
+        SystemTime time;
+        const std::vector<TimePoint> deadlines = Deadlines(count, time.GetCurrent());
+        std::vector<double> lateness(count);
+        TimingWheel wheel(time, milliseconds(1), [&](const std::vector<WheelTimer*>& expired)
+        {
+            const TimePoint now = Clock::now();
+            for (WheelTimer* timer : expired)
+            {
+                lateness[timer->Id()] = duration<double, std::micro>(now - deadlines[timer->Id()]).count();
+            }
+        });
+        std::vector<std::unique_ptr<WheelTimer>> timers;
+        timers.reserve(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Timers start from the time of the last Advance
+            timers.emplace_back(new WheelTimer(wheel, deadlines[i] - wheel.Now(), i));
+            timers.back()->Start();
+        }
+        while (wheel.Size() != 0)
+        {
+            std::this_thread::sleep_for(microseconds(100));
+            wheel.Advance();
+        }
+        AddJitter(results, "TimingWheel.dispatch", lateness);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string path;
+    size_t maxTimers = 1000000;
+    for (int arg = 1; arg < argc; ++arg)
+    {
+        if (std::strcmp(argv[arg], "--quick") == 0)
+        {
+            maxTimers = 10000;
+        }
+        else
+        {
+            path = argv[arg];
+        }
+    }
+
+    std::vector<std::string> results;
+    CallCosts(results);
+    for (size_t count = 1000; count <= maxTimers; count *= 10)
+    {
+        ServiceJitter(results, count);
+        WheelJitter(results, count);
+    }
+
+    std::ostringstream json;
+    json << "{\"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        json << "  " << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    json << "]}\n";
+
+    if (path.empty())
+    {
+        std::cout << json.str();
+        return 0;
+    }
+    std::ofstream file(path);
+    file << json.str();
+    if (!file)
+    {
+        std::cerr << "Can not write " << path << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -13,3 +13,412 @@ If your language provides a method in the standard library that does this look-u
 */
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LEAP_YEAR_SSE2
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+/*
+ * Division free leap year rule:
+ *   year % 100 == 0 is the same as year % 25 == 0 for years divisible by 4,
+ *   and year % 400 == 0 is the same as year % 16 == 0 for years divisible by 100.
+ *   Divisibility by 4 and 16 is a mask, divisibility by 25 is checked with multiplication by
+ *   the modular inverse of 25: multiples of 25 are exactly the numbers mapped into a narrow range.
+ *
+ * ClassifyLeapYears evaluates the same rule 16 years per step with SSE2 and falls back to the scalar one.
+*/
+
+static const uint32_t s_inverseOf25 = 0xC28F5C29u;       // 25 * s_inverseOf25 == 1 (mod 2^32)
+static const uint32_t s_multiplesOf25Offset = 85899345u;  // INT32_MAX / 25
+static const uint32_t s_multiplesOf25Bound = 171798690u;  // 2 * INT32_MAX / 25
+
+constexpr bool IsDivisibleBy25(int32_t year)
+{
+    return static_cast<uint32_t>(static_cast<uint32_t>(year) * s_inverseOf25 + s_multiplesOf25Offset) <= s_multiplesOf25Bound;
+}
+
+constexpr bool IsLeapYear(int32_t year)
+{
+    return (year & 3) == 0 && (!IsDivisibleBy25(year) || (year & 15) == 0);
+}
+
+#ifdef LEAP_YEAR_SSE2
+inline __m128i MultiplyLow32(__m128i values, __m128i multiplier)
+{
+#if defined(__SSE4_1__)
+    return _mm_mullo_epi32(values, multiplier);
+#else
+    const __m128i even = _mm_mul_epu32(values, multiplier);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(values, 32), _mm_srli_epi64(multiplier, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+// Returns all ones in the lanes holding leap years
+inline __m128i LeapYearMask(__m128i years)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i signBit = _mm_set1_epi32(INT32_MIN);
+    const __m128i divisibleBy4 = _mm_cmpeq_epi32(_mm_and_si128(years, _mm_set1_epi32(3)), zero);
+    const __m128i divisibleBy16 = _mm_cmpeq_epi32(_mm_and_si128(years, _mm_set1_epi32(15)), zero);
+    const __m128i mapped = _mm_add_epi32(MultiplyLow32(years, _mm_set1_epi32(static_cast<int32_t>(s_inverseOf25))),
+                                         _mm_set1_epi32(static_cast<int32_t>(s_multiplesOf25Offset)));
+    // SSE2 has only signed comparison, flipping the sign bit turns it into an unsigned one
+    const __m128i notDivisibleBy25 = _mm_cmpgt_epi32(_mm_xor_si128(mapped, signBit),
+                                                     _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(s_multiplesOf25Bound)), signBit));
+    return _mm_and_si128(divisibleBy4, _mm_or_si128(notDivisibleBy25, divisibleBy16));
+}
+#endif
+
+// Writes 1 for leap years and 0 for common years into result[0..count)
+void ClassifyLeapYears(const int32_t* years, uint8_t* result, size_t count)
+{
+    size_t i = 0;
+#ifdef LEAP_YEAR_SSE2
+    const __m128i one = _mm_set1_epi8(1);
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i* source = reinterpret_cast<const __m128i*>(years + i);
+        const __m128i low = _mm_packs_epi32(LeapYearMask(_mm_loadu_si128(source)),
+                                            LeapYearMask(_mm_loadu_si128(source + 1)));
+        const __m128i high = _mm_packs_epi32(LeapYearMask(_mm_loadu_si128(source + 2)),
+                                             LeapYearMask(_mm_loadu_si128(source + 3)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(result + i), _mm_and_si128(_mm_packs_epi16(low, high), one));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        result[i] = IsLeapYear(years[i]) ? 1 : 0;
+    }
+}
+
+static_assert(IsLeapYear(1996), "1996 is a leap year");
+static_assert(!IsLeapYear(1997), "1997 is a common year");
+static_assert(!IsLeapYear(1900), "1900 is a common year");
+static_assert(IsLeapYear(2000), "2000 is a leap year");
+
+bool IsLeapYearNaive(int32_t year)
+{
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+TEST(LeapYear, CommonYear)
+{
+    ASSERT_FALSE(IsLeapYear(1997));
+}
+
+TEST(LeapYear, DivisibleBy4)
+{
+    ASSERT_TRUE(IsLeapYear(1996));
+}
+
+TEST(LeapYear, DivisibleBy100)
+{
+    ASSERT_FALSE(IsLeapYear(1900));
+}
+
+TEST(LeapYear, DivisibleBy400)
+{
+    ASSERT_TRUE(IsLeapYear(2000));
+}
+
+TEST(LeapYear, DivisibleBy25Only)
+{
+    ASSERT_FALSE(IsLeapYear(1925));
+    ASSERT_FALSE(IsLeapYear(2025));
+}
+
+TEST(LeapYear, MatchesNaiveRule)
+{
+    for (int32_t year = -100000; year <= 100000; ++year)
+    {
+        ASSERT_EQ(IsLeapYearNaive(year), IsLeapYear(year)) << year;
+    }
+    for (int32_t year : {INT32_MIN, INT32_MIN + 4, INT32_MIN + 100, INT32_MAX, INT32_MAX - 47, INT32_MAX - 447})
+    {
+        ASSERT_EQ(IsLeapYearNaive(year), IsLeapYear(year)) << year;
+    }
+}
+
+TEST(LeapYear, ClassifyEmpty)
+{
+    ClassifyLeapYears(nullptr, nullptr, 0);
+}
+
+TEST(LeapYear, ClassifyBatch)
+{
+    std::vector<int32_t> years;
+    for (int32_t year = 1500; year < 2537; ++year)
+    {
+        years.push_back(year);
+    }
+    years.push_back(INT32_MIN);
+    years.push_back(INT32_MAX);
+
+    std::vector<uint8_t> result(years.size(), 42);
+    ClassifyLeapYears(years.data(), result.data(), years.size());
+    for (size_t i = 0; i < years.size(); ++i)
+    {
+        ASSERT_EQ(IsLeapYearNaive(years[i]) ? 1 : 0, result[i]) << years[i];
+    }
+}
+
+TEST(LeapYearBenchmark, DISABLED_ClassifyVersusNaive)
+{
+    const size_t count = 1 << 24;
+    std::vector<int32_t> years(count);
+    uint32_t seed = 12345;
+    for (int32_t& year : years)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        year = static_cast<int32_t>(seed >> 8) % 100000 - 50000;
+    }
+    std::vector<uint8_t> naive(count);
+    std::vector<uint8_t> batch(count);
+
+    const auto naiveStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        naive[i] = IsLeapYearNaive(years[i]) ? 1 : 0;
+    }
+    const auto naiveTime = std::chrono::steady_clock::now() - naiveStart;
+
+    const auto batchStart = std::chrono::steady_clock::now();
+    ClassifyLeapYears(years.data(), batch.data(), count);
+    const auto batchTime = std::chrono::steady_clock::now() - batchStart;
+
+    ASSERT_EQ(naive, batch);
+    std::cout << "naive: " << std::chrono::duration<double, std::nano>(naiveTime).count() / count << " ns/year, "
+              << "batch: " << std::chrono::duration<double, std::nano>(batchTime).count() / count << " ns/year" << std::endl;
+    EXPECT_LT(batchTime, naiveTime);
+}
+
+/*
+ * Gregorian calendar arithmetic on top of IsLeapYear.
+ *
+ * Day numbers count days since 1970-01-01 (negative before it), the proleptic Gregorian calendar is used.
+ * DaysFromCivil and CivilFromDays are Howard Hinnant's algorithms: years are shifted to start on March 1st,
+ * so the leap day is the last day of a year and no loop over years or months is required.
+ * The batch versions are plain loops over branch free code, which lets the compiler vectorize them.
+*/
+
+struct CivilDate
+{
+    int32_t year;
+    uint32_t month; // [1, 12]
+    uint32_t day;   // [1, 31]
+
+    constexpr bool operator==(const CivilDate& right) const
+    {
+        return year == right.year && month == right.month && day == right.day;
+    }
+};
+
+std::ostream& operator<<(std::ostream& stream, const CivilDate& date)
+{
+    return stream << date.year << '-' << date.month << '-' << date.day;
+}
+
+static constexpr uint32_t s_daysBeforeMonth[12] = {0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334};
+static const int32_t s_daysFromEpochToMarch1st0000 = 719468;
+static const int32_t s_daysInEra = 146097;
+
+constexpr uint32_t DaysInMonth(int32_t year, uint32_t month)
+{
+    return month == 2 ? 28 + IsLeapYear(year) : 30 + ((month + (month >> 3)) & 1);
+}
+
+constexpr uint32_t DayOfYear(int32_t year, uint32_t month, uint32_t day)
+{
+    return s_daysBeforeMonth[month - 1] + day + (month > 2 && IsLeapYear(year));
+}
+
+constexpr int32_t DaysFromCivil(int32_t year, uint32_t month, uint32_t day)
+{
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yearOfEra = static_cast<uint32_t>(year - era * 400);            // [0, 399]
+    const uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1; // [0, 365]
+    const uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear; // [0, 146096]
+    return era * s_daysInEra + static_cast<int32_t>(dayOfEra) - s_daysFromEpochToMarch1st0000;
+}
+
+constexpr int32_t DaysFromCivil(const CivilDate& date)
+{
+    return DaysFromCivil(date.year, date.month, date.day);
+}
+
+constexpr CivilDate CivilFromDays(int32_t days)
+{
+    days += s_daysFromEpochToMarch1st0000;
+    const int32_t era = (days >= 0 ? days : days - (s_daysInEra - 1)) / s_daysInEra;
+    const uint32_t dayOfEra = static_cast<uint32_t>(days - era * s_daysInEra);                             // [0, 146096]
+    const uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365; // [0, 399]
+    const uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);             // [0, 365]
+    const uint32_t shiftedMonth = (5 * dayOfYear + 2) / 153;                                               // [0, 11], March is 0
+    const uint32_t month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    return CivilDate{static_cast<int32_t>(yearOfEra) + era * 400 + (month <= 2),
+                     month,
+                     dayOfYear - (153 * shiftedMonth + 2) / 5 + 1};
+}
+
+void DaysFromCivil(const CivilDate* dates, int32_t* days, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        days[i] = DaysFromCivil(dates[i]);
+    }
+}
+
+void CivilFromDays(const int32_t* days, CivilDate* dates, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        dates[i] = CivilFromDays(days[i]);
+    }
+}
+
+static_assert(DaysInMonth(2000, 2) == 29, "February 2000 has a leap day");
+static_assert(DaysFromCivil(1970, 1, 1) == 0, "Day numbers start at the epoch");
+static_assert(CivilFromDays(11017) == CivilDate{2000, 3, 1}, "Day 11017 is March 1st, 2000");
+
+// Reference implementation, walks over years and months from the epoch
+int32_t DaysFromCivilNaive(int32_t year, uint32_t month, uint32_t day)
+{
+    int32_t days = 0;
+    for (int32_t y = 1970; y < year; ++y)
+    {
+        days += IsLeapYearNaive(y) ? 366 : 365;
+    }
+    for (int32_t y = year; y < 1970; ++y)
+    {
+        days -= IsLeapYearNaive(y) ? 366 : 365;
+    }
+    for (uint32_t m = 1; m < month; ++m)
+    {
+        days += m == 2 ? (IsLeapYearNaive(year) ? 29 : 28) : (m == 4 || m == 6 || m == 9 || m == 11 ? 30 : 31);
+    }
+    return days + static_cast<int32_t>(day) - 1;
+}
+
+TEST(Calendar, DaysInMonth)
+{
+    const uint32_t expected[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    for (uint32_t month = 1; month <= 12; ++month)
+    {
+        ASSERT_EQ(expected[month - 1], DaysInMonth(2018, month)) << month;
+    }
+    ASSERT_EQ(29u, DaysInMonth(2016, 2));
+    ASSERT_EQ(28u, DaysInMonth(1900, 2));
+}
+
+TEST(Calendar, DayOfYear)
+{
+    ASSERT_EQ(1u, DayOfYear(2018, 1, 1));
+    ASSERT_EQ(243u, DayOfYear(2018, 8, 31));
+    ASSERT_EQ(244u, DayOfYear(2016, 8, 31));
+    ASSERT_EQ(366u, DayOfYear(2000, 12, 31));
+    ASSERT_EQ(365u, DayOfYear(1900, 12, 31));
+}
+
+TEST(Calendar, DaysFromCivil)
+{
+    ASSERT_EQ(0, DaysFromCivil(1970, 1, 1));
+    ASSERT_EQ(17774, DaysFromCivil(2018, 8, 31));
+    ASSERT_EQ(-25509, DaysFromCivil(1900, 2, 28));
+    ASSERT_EQ(-719162, DaysFromCivil(1, 1, 1));
+}
+
+TEST(Calendar, CivilFromDays)
+{
+    ASSERT_EQ((CivilDate{1970, 1, 1}), CivilFromDays(0));
+    ASSERT_EQ((CivilDate{2018, 8, 31}), CivilFromDays(17774));
+    ASSERT_EQ((CivilDate{1900, 2, 28}), CivilFromDays(-25509));
+    ASSERT_EQ((CivilDate{2000, 2, 29}), CivilFromDays(11016));
+}
+
+TEST(Calendar, MatchesNaiveWalk)
+{
+    for (int32_t year = 1600; year <= 2400; ++year)
+    {
+        for (uint32_t month = 1; month <= 12; ++month)
+        {
+            ASSERT_EQ(DaysFromCivilNaive(year, month, 1), DaysFromCivil(year, month, 1)) << year << '-' << month;
+        }
+    }
+}
+
+TEST(Calendar, RoundTrip)
+{
+    for (int32_t days = -1000000; days <= 1000000; ++days)
+    {
+        const CivilDate date = CivilFromDays(days);
+        ASSERT_EQ(days, DaysFromCivil(date)) << date;
+        ASSERT_LE(date.day, DaysInMonth(date.year, date.month)) << date;
+    }
+}
+
+TEST(Calendar, Batch)
+{
+    std::vector<int32_t> days;
+    for (int32_t day = -800; day < 800; day += 7)
+    {
+        days.push_back(day);
+    }
+    std::vector<CivilDate> dates(days.size());
+    CivilFromDays(days.data(), dates.data(), days.size());
+    std::vector<int32_t> converted(days.size());
+    DaysFromCivil(dates.data(), converted.data(), dates.size());
+
+    ASSERT_EQ(days, converted);
+    for (size_t i = 0; i < days.size(); ++i)
+    {
+        ASSERT_EQ(CivilFromDays(days[i]), dates[i]);
+    }
+}
+
+TEST(CalendarBenchmark, DISABLED_DaysFromCivilVersusNaive)
+{
+    const size_t count = 1 << 22;
+    std::vector<CivilDate> dates(count);
+    uint32_t seed = 12345;
+    for (CivilDate& date : dates)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        date = CivilFromDays(static_cast<int32_t>(seed >> 8) % 73000 - 36500);
+    }
+    std::vector<int32_t> naive(count);
+    std::vector<int32_t> batch(count);
+
+    const auto naiveStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        naive[i] = DaysFromCivilNaive(dates[i].year, dates[i].month, dates[i].day);
+    }
+    const auto naiveTime = std::chrono::steady_clock::now() - naiveStart;
+
+    const auto batchStart = std::chrono::steady_clock::now();
+    DaysFromCivil(dates.data(), batch.data(), count);
+    const auto batchTime = std::chrono::steady_clock::now() - batchStart;
+
+    std::vector<CivilDate> roundTrip(count);
+    const auto reverseStart = std::chrono::steady_clock::now();
+    CivilFromDays(batch.data(), roundTrip.data(), count);
+    const auto reverseTime = std::chrono::steady_clock::now() - reverseStart;
+
+    ASSERT_EQ(naive, batch);
+    ASSERT_TRUE(dates == roundTrip);
+    std::cout << "naive: " << std::chrono::duration<double, std::nano>(naiveTime).count() / count << " ns/date, "
+              << "DaysFromCivil: " << std::chrono::duration<double, std::nano>(batchTime).count() / count << " ns/date, "
+              << "CivilFromDays: " << std::chrono::duration<double, std::nano>(reverseTime).count() / count << " ns/date" << std::endl;
+    EXPECT_LT(batchTime, naiveTime);
+}
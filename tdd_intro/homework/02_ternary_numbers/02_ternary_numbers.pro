@@ -1,9 +1,16 @@
 include(../../gtest.pri)
 
 TEMPLATE = app
-CONFIG += console c++11
+CONFIG += console c++14
 CONFIG -= app_bundle
 CONFIG -= qt
 
 SOURCES += \
-    test.cpp
+    test.cpp \
+    radixtest.cpp \
+    packedtrits.cpp \
+    packedtritstest.cpp
+
+HEADERS += \
+    radix.h \
+    packedtrits.h
@@ -0,0 +1,190 @@
+#include "packedtrits.h"
+#include <cstring>
+#include <utility>
+
+namespace
+{
+    const uint8_t s_powersOf3[s_tritsPerByte + 1] = {1, 3, 9, 27, 81, 243};
+    const uint8_t s_wordCount = 243;
+
+    struct TritText
+    {
+        char digits[s_wordCount][s_tritsPerByte];
+    };
+
+    constexpr TritText MakeTritText()
+    {
+        TritText text{};
+        for (size_t word = 0; word < s_wordCount; ++word)
+        {
+            size_t value = word;
+            for (size_t trit = 0; trit < s_tritsPerByte; ++trit)
+            {
+                text.digits[word][trit] = static_cast<char>('0' + value % 3);
+                value /= 3;
+            }
+        }
+        return text;
+    }
+
+    constexpr TritText s_tritText = MakeTritText();
+
+    size_t ByteCount(size_t size)
+    {
+        return (size + s_tritsPerByte - 1) / s_tritsPerByte;
+    }
+
+    size_t LastWordTrits(size_t size)
+    {
+        return size - (ByteCount(size) - 1) * s_tritsPerByte;
+    }
+
+    int BalancedOffset(size_t tritCount)
+    {
+        return (s_powersOf3[tritCount] - 1) / 2;
+    }
+
+    // Balanced value of the byte of value, or 0 past its end
+    int BalancedWordValue(const PackedTrits& value, size_t byte)
+    {
+        if (byte >= value.Bytes().size())
+        {
+            return 0;
+        }
+        const size_t tritCount = byte + 1 == value.Bytes().size() ? LastWordTrits(value.Size()) : s_tritsPerByte;
+        return value.Bytes()[byte] - BalancedOffset(tritCount);
+    }
+}
+
+PackedTrits::PackedTrits()
+    : m_size(0)
+{ }
+
+PackedTrits::PackedTrits(size_t size)
+    : m_bytes(ByteCount(size), 0), m_size(size)
+{ }
+
+PackedTrits::PackedTrits(std::vector<uint8_t> bytes, size_t size)
+    : m_bytes(std::move(bytes)), m_size(size)
+{ }
+
+bool PackedTrits::Assign(const char* text, size_t size)
+{
+    std::vector<uint8_t> bytes(ByteCount(size), 0);
+    for (size_t byte = 0, begin = 0; begin < size; ++byte, begin += s_tritsPerByte)
+    {
+        const size_t end = begin + s_tritsPerByte < size ? begin + s_tritsPerByte : size;
+        unsigned word = 0;
+        unsigned invalid = 0;
+        for (size_t i = end; i-- > begin;)
+        {
+            const unsigned trit = static_cast<unsigned char>(text[i]) - static_cast<unsigned>('0');
+            invalid |= trit > 2;
+            word = word * 3 + trit;
+        }
+        if (invalid)
+        {
+            return false;
+        }
+        bytes[byte] = static_cast<uint8_t>(word);
+    }
+    m_bytes.swap(bytes);
+    m_size = size;
+    return true;
+}
+
+bool PackedTrits::Assign(const std::string& text)
+{
+    return Assign(text.data(), text.size());
+}
+
+void PackedTrits::Decode(char* text) const
+{
+    if (m_size == 0)
+    {
+        return;
+    }
+    const size_t fullBytes = m_bytes.size() - 1;
+    for (size_t byte = 0; byte < fullBytes; ++byte)
+    {
+        std::memcpy(text + byte * s_tritsPerByte, s_tritText.digits[m_bytes[byte]], s_tritsPerByte);
+    }
+    std::memcpy(text + fullBytes * s_tritsPerByte, s_tritText.digits[m_bytes.back()], LastWordTrits(m_size));
+}
+
+std::string PackedTrits::ToString() const
+{
+    std::string text(m_size, '0');
+    Decode(&text[0]);
+    return text;
+}
+
+uint8_t PackedTrits::Get(size_t index) const
+{
+    return static_cast<uint8_t>(s_tritText.digits[m_bytes[index / s_tritsPerByte]][index % s_tritsPerByte] - '0');
+}
+
+void PackedTrits::Set(size_t index, uint8_t trit)
+{
+    const int delta = (static_cast<int>(trit) - Get(index)) * s_powersOf3[index % s_tritsPerByte];
+    m_bytes[index / s_tritsPerByte] = static_cast<uint8_t>(m_bytes[index / s_tritsPerByte] + delta);
+}
+
+uint8_t NegateBalancedWord(uint8_t word, size_t tritCount)
+{
+    // Every digit d becomes 2 - d
+    return static_cast<uint8_t>(s_powersOf3[tritCount] - 1 - word);
+}
+
+uint8_t AddBalancedWords(uint8_t left, uint8_t right, int& carry, size_t tritCount)
+{
+    const int offset = BalancedOffset(tritCount);
+    int sum = left + right - 2 * offset + carry;
+    carry = (sum > offset) - (sum < -offset);
+    sum -= carry * s_powersOf3[tritCount];
+    return static_cast<uint8_t>(sum + offset);
+}
+
+PackedTrits NegateBalanced(const PackedTrits& value)
+{
+    const std::vector<uint8_t>& bytes = value.Bytes();
+    std::vector<uint8_t> negated(bytes.size());
+    for (size_t byte = 0; byte < bytes.size(); ++byte)
+    {
+        const size_t tritCount = byte + 1 == bytes.size() ? LastWordTrits(value.Size()) : s_tritsPerByte;
+        negated[byte] = NegateBalancedWord(bytes[byte], tritCount);
+    }
+    return PackedTrits(std::move(negated), value.Size());
+}
+
+PackedTrits AddBalanced(const PackedTrits& left, const PackedTrits& right)
+{
+    const size_t size = left.Size() >= right.Size() ? left.Size() : right.Size();
+    const size_t bytes = ByteCount(size);
+
+    std::vector<uint8_t> sum(bytes);
+    int carry = 0;
+    for (size_t byte = 0; byte < bytes; ++byte)
+    {
+        const size_t tritCount = byte + 1 == bytes ? LastWordTrits(size) : s_tritsPerByte;
+        const int offset = BalancedOffset(tritCount);
+        const uint8_t leftWord = static_cast<uint8_t>(BalancedWordValue(left, byte) + offset);
+        const uint8_t rightWord = static_cast<uint8_t>(BalancedWordValue(right, byte) + offset);
+        sum[byte] = AddBalancedWords(leftWord, rightWord, carry, tritCount);
+    }
+    if (carry == 0)
+    {
+        return PackedTrits(std::move(sum), size);
+    }
+
+    const uint8_t carryTrit = static_cast<uint8_t>(carry + 1);
+    if (size % s_tritsPerByte == 0)
+    {
+        sum.push_back(carryTrit);
+    }
+    else
+    {
+        sum.back() = static_cast<uint8_t>(sum.back() + carryTrit * s_powersOf3[size % s_tritsPerByte]);
+    }
+    return PackedTrits(std::move(sum), size + 1);
+}
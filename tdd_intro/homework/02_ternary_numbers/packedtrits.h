@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Array of trits (0, 1 or 2) packed 5 per byte: byte = t0 + 3*t1 + 9*t2 + 27*t3 + 81*t4, 3^5 = 243 fits in 8 bits.
+ * Trits past Size() in the last byte are always 0.
+ * Random access and decoding go through a table with the 5 digits of every byte value.
+ *
+ * Balanced ternary: a trit t means the digit t - 1 (so '0' is -1, '1' is 0 and '2' is +1),
+ * trit i has weight 3^i, so the first trit is the least significant one.
+ * A packed word of k trits stores its balanced value v as v + (3^k - 1) / 2.
+*/
+
+class PackedTrits
+{
+public:
+    PackedTrits();
+    // Creates size trits equal to 0
+    explicit PackedTrits(size_t size);
+    // Takes already packed bytes holding size trits
+    PackedTrits(std::vector<uint8_t> bytes, size_t size);
+
+    // Replaces content with '0'/'1'/'2' text, returns false and keeps content if text has other characters
+    bool Assign(const char* text, size_t size);
+    bool Assign(const std::string& text);
+    // Writes Size() characters into text
+    void Decode(char* text) const;
+    std::string ToString() const;
+
+    uint8_t Get(size_t index) const;
+    void Set(size_t index, uint8_t trit);
+
+    size_t Size() const { return m_size; }
+    const std::vector<uint8_t>& Bytes() const { return m_bytes; }
+
+private:
+    std::vector<uint8_t> m_bytes;
+    size_t m_size;
+};
+
+static const size_t s_tritsPerByte = 5;
+
+// Balanced ternary arithmetic on single packed words of tritCount (1..5) trits
+uint8_t NegateBalancedWord(uint8_t word, size_t tritCount = s_tritsPerByte);
+// Adds words with incoming carry (-1, 0 or 1), carry is replaced by the outgoing one
+uint8_t AddBalancedWords(uint8_t left, uint8_t right, int& carry, size_t tritCount = s_tritsPerByte);
+
+// Balanced ternary arithmetic on whole arrays.
+// The sum has as many trits as the longer operand and one more if there is a carry out of it.
+PackedTrits NegateBalanced(const PackedTrits& value);
+PackedTrits AddBalanced(const PackedTrits& left, const PackedTrits& right);
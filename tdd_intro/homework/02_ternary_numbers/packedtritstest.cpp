@@ -0,0 +1,184 @@
+#include <gtest/gtest.h>
+#include "packedtrits.h"
+#include <chrono>
+#include <iostream>
+
+// Balanced value of '0'/'1'/'2' text, the first character is the least significant trit
+int64_t BalancedValue(const std::string& text)
+{
+    int64_t value = 0;
+    for (size_t i = text.size(); i-- > 0;)
+    {
+        value = value * 3 + (text[i] - '1');
+    }
+    return value;
+}
+
+std::string BalancedText(int64_t value)
+{
+    std::string text;
+    while (value != 0)
+    {
+        int64_t digit = ((value % 3) + 3) % 3;
+        if (digit == 2)
+        {
+            digit = -1;
+        }
+        text += static_cast<char>('1' + digit);
+        value = (value - digit) / 3;
+    }
+    return text;
+}
+
+PackedTrits MakePacked(const std::string& text)
+{
+    PackedTrits trits;
+    EXPECT_TRUE(trits.Assign(text));
+    return trits;
+}
+
+TEST(PackedTrits, Empty)
+{
+    PackedTrits trits;
+    ASSERT_EQ(0u, trits.Size());
+    ASSERT_EQ("", trits.ToString());
+}
+
+TEST(PackedTrits, Zeros)
+{
+    PackedTrits trits(7);
+    ASSERT_EQ("0000000", trits.ToString());
+    ASSERT_EQ(2u, trits.Bytes().size());
+}
+
+TEST(PackedTrits, FiveTritsPerByte)
+{
+    PackedTrits trits = MakePacked("21012");
+    ASSERT_EQ(1u, trits.Bytes().size());
+    ASSERT_EQ(2 + 3 * 1 + 9 * 0 + 27 * 1 + 81 * 2, trits.Bytes()[0]);
+}
+
+TEST(PackedTrits, RoundTrip)
+{
+    const std::string text = "102012" "2222201" "000012";
+    ASSERT_EQ(text, MakePacked(text).ToString());
+    ASSERT_EQ(4u, MakePacked(text).Bytes().size());
+}
+
+TEST(PackedTrits, InvalidTextKeepsContent)
+{
+    PackedTrits trits = MakePacked("120");
+    ASSERT_FALSE(trits.Assign("1203"));
+    ASSERT_FALSE(trits.Assign("12 0"));
+    ASSERT_EQ("120", trits.ToString());
+}
+
+TEST(PackedTrits, RandomAccess)
+{
+    const std::string text = "102012222201";
+    PackedTrits trits = MakePacked(text);
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        ASSERT_EQ(text[i] - '0', trits.Get(i)) << i;
+    }
+}
+
+TEST(PackedTrits, Set)
+{
+    PackedTrits trits(11);
+    trits.Set(0, 2);
+    trits.Set(4, 1);
+    trits.Set(10, 2);
+    trits.Set(4, 2);
+    ASSERT_EQ("20002000002", trits.ToString());
+}
+
+TEST(PackedTrits, NegateWord)
+{
+    ASSERT_EQ(242, NegateBalancedWord(0));
+    ASSERT_EQ(121, NegateBalancedWord(121));
+    ASSERT_EQ(0, NegateBalancedWord(2, 1));
+}
+
+TEST(PackedTrits, AddWords)
+{
+    int carry = 0;
+    // 1 + 1 = 2 is +1 +1 in balanced ternary
+    ASSERT_EQ(121 + 2, AddBalancedWords(121 + 1, 121 + 1, carry));
+    ASSERT_EQ(0, carry);
+    // 121 + 1 = 122 is 1 * 243 - 121
+    ASSERT_EQ(0, AddBalancedWords(242, 121 + 1, carry));
+    ASSERT_EQ(1, carry);
+    carry = -1;
+    ASSERT_EQ(121 - 1, AddBalancedWords(121, 121, carry));
+    ASSERT_EQ(0, carry);
+}
+
+TEST(PackedTrits, Negate)
+{
+    for (int64_t value : {0, 1, -1, 5, -121, 122, 1000000, -987654321})
+    {
+        const std::string text = BalancedText(value) + "1";
+        ASSERT_EQ(-value, BalancedValue(NegateBalanced(MakePacked(text)).ToString())) << value;
+    }
+}
+
+TEST(PackedTrits, Add)
+{
+    const int64_t values[] = {0, 1, -1, 2, 13, -40, 121, -121, 122, 364, 29524, -29525, 1234567, -7654321};
+    for (int64_t left : values)
+    {
+        for (int64_t right : values)
+        {
+            const PackedTrits sum = AddBalanced(MakePacked(BalancedText(left)), MakePacked(BalancedText(right)));
+            ASSERT_EQ(left + right, BalancedValue(sum.ToString())) << left << " + " << right;
+        }
+    }
+}
+
+TEST(PackedTrits, AddCarryGrowsSize)
+{
+    // 1 + 1 with single trits is "2" + "2" = 2 = -1 + 3
+    const PackedTrits sum = AddBalanced(MakePacked("2"), MakePacked("2"));
+    ASSERT_EQ("02", sum.ToString());
+    const PackedTrits wide = AddBalanced(MakePacked("22222"), MakePacked("2"));
+    ASSERT_EQ(6u, wide.Size());
+    ASSERT_EQ(122, BalancedValue(wide.ToString()));
+}
+
+TEST(PackedTritsBenchmark, DISABLED_MemoryAndThroughput)
+{
+    const size_t count = 100000000;
+    std::string text(count, '0');
+    uint32_t seed = 12345;
+    for (char& c : text)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        c = static_cast<char>('0' + (seed >> 16) % 3);
+    }
+
+    PackedTrits trits;
+    const auto encodeStart = std::chrono::steady_clock::now();
+    ASSERT_TRUE(trits.Assign(text));
+    const auto encodeTime = std::chrono::steady_clock::now() - encodeStart;
+
+    std::string decoded(count, ' ');
+    const auto decodeStart = std::chrono::steady_clock::now();
+    trits.Decode(&decoded[0]);
+    const auto decodeTime = std::chrono::steady_clock::now() - decodeStart;
+
+    size_t sum = 0;
+    const auto accessStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i += 7)
+    {
+        sum += trits.Get(i);
+    }
+    const auto accessTime = std::chrono::steady_clock::now() - accessStart;
+
+    ASSERT_EQ(text, decoded);
+    ASSERT_LT(0u, sum);
+    std::cout << "string: " << text.size() << " bytes, packed: " << trits.Bytes().size() << " bytes\n"
+              << "encode: " << count / std::chrono::duration<double, std::micro>(encodeTime).count() << " Mtrits/s, "
+              << "decode: " << count / std::chrono::duration<double, std::micro>(decodeTime).count() << " Mtrits/s, "
+              << "random access: " << std::chrono::duration<double, std::nano>(accessTime).count() / (count / 7) << " ns" << std::endl;
+}
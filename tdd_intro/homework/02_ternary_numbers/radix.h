@@ -0,0 +1,258 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+/*
+ * Parsing and formatting of unsigned integers in bases 2..36.
+ *
+ * The base is a template parameter, so multiplications, divisions and overflow limits are
+ * compile-time constants which the compiler strength-reduces (shifts for powers of two, multiply-high otherwise).
+ * Functions taking the base at runtime dispatch through a table of those instantiations.
+ *
+ * Digits are '0'..'9' followed by letters, parsing accepts both cases, formatting produces lowercase.
+ * Empty strings, digits not valid in the base and values above uint64_t are errors;
+ * FromRadix and ParseRadixBatch keep the ternary homework semantics and convert them to 0.
+*/
+
+enum class RadixStatus
+{
+    Ok,
+    InvalidDigit,
+    Overflow
+};
+
+static const uint32_t s_minRadix = 2;
+static const uint32_t s_maxRadix = 36;
+// Enough for uint64_t in base 2
+static const size_t s_maxRadixDigits = 64;
+
+namespace radix_detail
+{
+    static const uint8_t s_invalidDigit = 0xFF;
+
+    struct DigitTable
+    {
+        uint8_t values[256];
+    };
+
+    constexpr DigitTable MakeDigitTable()
+    {
+        DigitTable table{};
+        for (int c = 0; c < 256; ++c)
+        {
+            table.values[c] = s_invalidDigit;
+        }
+        for (int digit = 0; digit < 10; ++digit)
+        {
+            table.values['0' + digit] = static_cast<uint8_t>(digit);
+        }
+        for (int letter = 0; letter < 26; ++letter)
+        {
+            table.values['a' + letter] = static_cast<uint8_t>(10 + letter);
+            table.values['A' + letter] = static_cast<uint8_t>(10 + letter);
+        }
+        return table;
+    }
+
+    // Static members of a class template, so every translation unit shares one table, like RadixDispatch
+    template <typename = void>
+    struct Digits
+    {
+        static constexpr DigitTable s_values = MakeDigitTable();
+        static constexpr char s_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+    };
+
+    template <typename T>
+    constexpr DigitTable Digits<T>::s_values;
+
+    template <typename T>
+    constexpr char Digits<T>::s_chars[];
+
+    template <uint32_t Base>
+    struct CheckBase
+    {
+        static_assert(Base >= s_minRadix && Base <= s_maxRadix, "Base must be in range 2..36");
+    };
+}
+
+template <uint32_t Base>
+RadixStatus ParseRadix(const char* text, size_t size, uint64_t& value)
+{
+    radix_detail::CheckBase<Base>();
+    static const uint64_t s_limit = std::numeric_limits<uint64_t>::max() / Base;
+    static const uint64_t s_lastDigitLimit = std::numeric_limits<uint64_t>::max() % Base;
+
+    if (size == 0)
+    {
+        return RadixStatus::InvalidDigit;
+    }
+    uint64_t result = 0;
+    bool overflow = false;
+    for (size_t i = 0; i < size; ++i)
+    {
+        const uint32_t digit = radix_detail::Digits<>::s_values.values[static_cast<unsigned char>(text[i])];
+        if (digit >= Base)
+        {
+            return RadixStatus::InvalidDigit;
+        }
+        // Keep validating after overflow, invalid input takes precedence
+        overflow = overflow || result > s_limit || (result == s_limit && digit > s_lastDigitLimit);
+        result = result * Base + digit;
+    }
+    if (overflow)
+    {
+        return RadixStatus::Overflow;
+    }
+    value = result;
+    return RadixStatus::Ok;
+}
+
+// Writes digits of value into buffer (at least s_maxRadixDigits long) without terminating zero, returns their count
+template <uint32_t Base>
+size_t FormatRadix(uint64_t value, char* buffer)
+{
+    radix_detail::CheckBase<Base>();
+    char digits[s_maxRadixDigits];
+    char* begin = digits + s_maxRadixDigits;
+    do
+    {
+        *--begin = radix_detail::Digits<>::s_chars[value % Base];
+        value /= Base;
+    }
+    while (value != 0);
+
+    const size_t size = static_cast<size_t>(digits + s_maxRadixDigits - begin);
+    for (size_t i = 0; i < size; ++i)
+    {
+        buffer[i] = begin[i];
+    }
+    return size;
+}
+
+template <uint32_t Base>
+uint64_t FromRadix(const std::string& text)
+{
+    uint64_t value = 0;
+    ParseRadix<Base>(text.data(), text.size(), value);
+    return value;
+}
+
+template <uint32_t Base>
+std::string ToRadix(uint64_t value)
+{
+    char buffer[s_maxRadixDigits];
+    return std::string(buffer, FormatRadix<Base>(value, buffer));
+}
+
+// Converts texts[0..count) into values, invalid ones become 0.
+// Statuses are written only when the pointer is not null. Returns the number of invalid texts.
+template <uint32_t Base>
+size_t ParseRadixBatch(const std::string* texts, size_t count, uint64_t* values, RadixStatus* statuses = nullptr)
+{
+    size_t failures = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t value = 0;
+        const RadixStatus status = ParseRadix<Base>(texts[i].data(), texts[i].size(), value);
+        values[i] = value;
+        failures += status != RadixStatus::Ok;
+        if (statuses)
+        {
+            statuses[i] = status;
+        }
+    }
+    return failures;
+}
+
+namespace radix_detail
+{
+    typedef RadixStatus (*ParseFunction)(const char*, size_t, uint64_t&);
+    typedef size_t (*FormatFunction)(uint64_t, char*);
+    typedef size_t (*ParseBatchFunction)(const std::string*, size_t, uint64_t*, RadixStatus*);
+
+    struct RadixFunctions
+    {
+        ParseFunction parse;
+        FormatFunction format;
+        ParseBatchFunction parseBatch;
+    };
+
+    template <uint32_t... Offsets>
+    struct RadixDispatch
+    {
+        static constexpr RadixFunctions s_functions[] = {
+            {&ParseRadix<s_minRadix + Offsets>, &FormatRadix<s_minRadix + Offsets>, &ParseRadixBatch<s_minRadix + Offsets>}...
+        };
+    };
+
+    template <uint32_t... Offsets>
+    constexpr RadixFunctions RadixDispatch<Offsets...>::s_functions[];
+
+    template <uint32_t... Offsets>
+    const RadixFunctions& GetRadixFunctions(uint32_t base, std::integer_sequence<uint32_t, Offsets...>)
+    {
+        return RadixDispatch<Offsets...>::s_functions[base - s_minRadix];
+    }
+
+    inline const RadixFunctions& GetRadixFunctions(uint32_t base)
+    {
+        return GetRadixFunctions(base, std::make_integer_sequence<uint32_t, s_maxRadix - s_minRadix + 1>());
+    }
+
+    inline bool IsValidRadix(uint32_t base)
+    {
+        return base >= s_minRadix && base <= s_maxRadix;
+    }
+}
+
+// Runtime base versions, an unsupported base is reported as RadixStatus::InvalidDigit and formats nothing
+inline RadixStatus ParseRadix(const char* text, size_t size, uint32_t base, uint64_t& value)
+{
+    if (!radix_detail::IsValidRadix(base))
+    {
+        return RadixStatus::InvalidDigit;
+    }
+    return radix_detail::GetRadixFunctions(base).parse(text, size, value);
+}
+
+inline size_t FormatRadix(uint64_t value, uint32_t base, char* buffer)
+{
+    if (!radix_detail::IsValidRadix(base))
+    {
+        return 0;
+    }
+    return radix_detail::GetRadixFunctions(base).format(value, buffer);
+}
+
+inline uint64_t FromRadix(const std::string& text, uint32_t base)
+{
+    uint64_t value = 0;
+    ParseRadix(text.data(), text.size(), base, value);
+    return value;
+}
+
+inline std::string ToRadix(uint64_t value, uint32_t base)
+{
+    char buffer[s_maxRadixDigits];
+    return std::string(buffer, FormatRadix(value, base, buffer));
+}
+
+inline size_t ParseRadixBatch(const std::string* texts, size_t count, uint32_t base, uint64_t* values, RadixStatus* statuses = nullptr)
+{
+    if (!radix_detail::IsValidRadix(base))
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            values[i] = 0;
+            if (statuses)
+            {
+                statuses[i] = RadixStatus::InvalidDigit;
+            }
+        }
+        return count;
+    }
+    return radix_detail::GetRadixFunctions(base).parseBatch(texts, count, values, statuses);
+}
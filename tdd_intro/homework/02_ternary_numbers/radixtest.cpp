@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "radix.h"
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+// Reference implementation with the base known only at runtime
+uint64_t FromRadixNaive(const std::string& text, uint32_t base)
+{
+    uint64_t value = 0;
+    for (char c : text)
+    {
+        uint32_t digit = 0;
+        if (c >= '0' && c <= '9')
+        {
+            digit = static_cast<uint32_t>(c - '0');
+        }
+        else if (c >= 'a' && c <= 'z')
+        {
+            digit = static_cast<uint32_t>(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'Z')
+        {
+            digit = static_cast<uint32_t>(c - 'A' + 10);
+        }
+        else
+        {
+            return 0;
+        }
+        if (digit >= base || value > (std::numeric_limits<uint64_t>::max() - digit) / base)
+        {
+            return 0;
+        }
+        value = value * base + digit;
+    }
+    return value;
+}
+
+TEST(Radix, Ternary)
+{
+    ASSERT_EQ(302u, FromRadix<3>("102012"));
+    ASSERT_EQ("102012", ToRadix<3>(302));
+}
+
+TEST(Radix, CommonBases)
+{
+    ASSERT_EQ(10u, FromRadix<2>("1010"));
+    ASSERT_EQ(493u, FromRadix<8>("755"));
+    ASSERT_EQ(1234567890u, FromRadix<10>("1234567890"));
+    ASSERT_EQ(0xDEADBEEFu, FromRadix<16>("DeadBeef"));
+    ASSERT_EQ(46655u, FromRadix<36>("zzz"));
+}
+
+TEST(Radix, FormatCommonBases)
+{
+    ASSERT_EQ("0", ToRadix<2>(0));
+    ASSERT_EQ("1010", ToRadix<2>(10));
+    ASSERT_EQ("755", ToRadix<8>(493));
+    ASSERT_EQ("deadbeef", ToRadix<16>(0xDEADBEEF));
+    ASSERT_EQ("zzz", ToRadix<36>(46655));
+    ASSERT_EQ(std::string(64, '1'), ToRadix<2>(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(Radix, InvalidMeansZero)
+{
+    ASSERT_EQ(0u, FromRadix<3>("3"));
+    ASSERT_EQ(0u, FromRadix<10>("12a"));
+    ASSERT_EQ(0u, FromRadix<16>("0x1F"));
+    ASSERT_EQ(0u, FromRadix<36>("z-z"));
+}
+
+TEST(Radix, InvalidStatus)
+{
+    uint64_t value = 42;
+    ASSERT_EQ(RadixStatus::InvalidDigit, ParseRadix<10>("", 0, value));
+    ASSERT_EQ(RadixStatus::InvalidDigit, ParseRadix<2>("102", 3, value));
+    ASSERT_EQ(42u, value);
+}
+
+TEST(Radix, Overflow)
+{
+    uint64_t value = 42;
+    ASSERT_EQ(RadixStatus::Ok, ParseRadix<10>("18446744073709551615", 20, value));
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(), value);
+    ASSERT_EQ(RadixStatus::Overflow, ParseRadix<10>("18446744073709551616", 20, value));
+    ASSERT_EQ(RadixStatus::Overflow, ParseRadix<16>("10000000000000000", 17, value));
+    ASSERT_EQ(RadixStatus::InvalidDigit, ParseRadix<16>("10000000000000000g", 18, value));
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(), value);
+}
+
+TEST(Radix, RuntimeBase)
+{
+    ASSERT_EQ(302u, FromRadix("102012", 3));
+    ASSERT_EQ("102012", ToRadix(302, 3));
+    ASSERT_EQ(46655u, FromRadix("ZZZ", 36));
+    ASSERT_EQ(0u, FromRadix("10", 1));
+    ASSERT_EQ(0u, FromRadix("10", 37));
+    ASSERT_EQ("", ToRadix(10, 37));
+}
+
+TEST(Radix, RoundTripAllBases)
+{
+    const uint64_t values[] = {0, 1, 35, 36, 1295, 1296, 4294967295u, 4294967296u, std::numeric_limits<uint64_t>::max()};
+    for (uint32_t base = s_minRadix; base <= s_maxRadix; ++base)
+    {
+        for (uint64_t value : values)
+        {
+            const std::string text = ToRadix(value, base);
+            ASSERT_EQ(value, FromRadix(text, base)) << text << " in base " << base;
+            ASSERT_EQ(value, FromRadixNaive(text, base)) << text << " in base " << base;
+        }
+    }
+}
+
+TEST(Radix, Batch)
+{
+    const std::string texts[] = {"102012", "", "3", "22"};
+    uint64_t values[4] = {1, 1, 1, 1};
+    RadixStatus statuses[4];
+    ASSERT_EQ(2u, ParseRadixBatch<3>(texts, 4, values, statuses));
+    ASSERT_EQ(302u, values[0]);
+    ASSERT_EQ(0u, values[1]);
+    ASSERT_EQ(0u, values[2]);
+    ASSERT_EQ(8u, values[3]);
+    ASSERT_EQ(RadixStatus::Ok, statuses[0]);
+    ASSERT_EQ(RadixStatus::InvalidDigit, statuses[2]);
+}
+
+TEST(Radix, RuntimeBaseBatch)
+{
+    const std::string texts[] = {"ff", "fg"};
+    uint64_t values[2] = {1, 1};
+    ASSERT_EQ(1u, ParseRadixBatch(texts, 2, 16, values));
+    ASSERT_EQ(255u, values[0]);
+    ASSERT_EQ(0u, values[1]);
+    ASSERT_EQ(2u, ParseRadixBatch(texts, 2, 40, values));
+    ASSERT_EQ(0u, values[0]);
+}
+
+template <uint32_t Base>
+void BenchmarkRadix()
+{
+    std::vector<std::string> texts(1 << 20);
+    uint64_t seed = 12345;
+    for (std::string& text : texts)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        text = ToRadix<Base>(seed >> (seed & 31));
+    }
+    std::vector<uint64_t> naive(texts.size());
+    std::vector<uint64_t> compiled(texts.size());
+    std::vector<uint64_t> dispatched(texts.size());
+
+    const auto naiveStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < texts.size(); ++i)
+    {
+        naive[i] = FromRadixNaive(texts[i], Base);
+    }
+    const auto naiveTime = std::chrono::steady_clock::now() - naiveStart;
+
+    const auto compiledStart = std::chrono::steady_clock::now();
+    ParseRadixBatch<Base>(texts.data(), texts.size(), compiled.data());
+    const auto compiledTime = std::chrono::steady_clock::now() - compiledStart;
+
+    const auto dispatchedStart = std::chrono::steady_clock::now();
+    ParseRadixBatch(texts.data(), texts.size(), Base, dispatched.data());
+    const auto dispatchedTime = std::chrono::steady_clock::now() - dispatchedStart;
+
+    char buffer[s_maxRadixDigits];
+    size_t formatted = 0;
+    const auto formatStart = std::chrono::steady_clock::now();
+    for (uint64_t value : compiled)
+    {
+        formatted += FormatRadix<Base>(value, buffer);
+    }
+    const auto formatTime = std::chrono::steady_clock::now() - formatStart;
+
+    ASSERT_EQ(naive, compiled);
+    ASSERT_EQ(naive, dispatched);
+    ASSERT_LT(0u, formatted);
+    const double count = static_cast<double>(texts.size());
+    std::cout << "base " << Base << ": "
+              << "naive parse " << std::chrono::duration<double, std::nano>(naiveTime).count() / count << " ns, "
+              << "compiled parse " << std::chrono::duration<double, std::nano>(compiledTime).count() / count << " ns, "
+              << "dispatched parse " << std::chrono::duration<double, std::nano>(dispatchedTime).count() / count << " ns, "
+              << "format " << std::chrono::duration<double, std::nano>(formatTime).count() / count << " ns" << std::endl;
+}
+
+TEST(RadixBenchmark, DISABLED_PerBase)
+{
+    BenchmarkRadix<2>();
+    BenchmarkRadix<3>();
+    BenchmarkRadix<8>();
+    BenchmarkRadix<10>();
+    BenchmarkRadix<16>();
+    BenchmarkRadix<36>();
+}
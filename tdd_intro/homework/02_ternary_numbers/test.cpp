@@ -16,3 +16,296 @@ The last place in a ternary number is the 1's place. The second to last is the 3
 
 If your language provides a method in the standard library to perform the conversion, pretend it doesn't exist and implement it yourself.
 */
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/*
+ * Architecture:
+ * ParseTernary validates and converts 8 characters per step (SWAR, eight digits in one 64-bit word):
+ *   all bytes are range checked against '0'..'2' at once,
+ *   adjacent digits are combined by three multiply-shift-mask steps: d*3+d, p*9+p, q*81+q,
+ *   the 8-digit chunk (up to 3^8 - 1) is accumulated with one multiplication by 3^8.
+ * The last partial chunk reloads the final 8 characters and masks out the already converted ones,
+ * so only strings shorter than 8 characters are converted one character at a time.
+ * Each accumulation is checked against the uint64_t limit, so overflow is reported instead of wrapping.
+ *
+ * TernaryToDecimal keeps the homework semantics: invalid (or too large) input is converted to 0.
+*/
+
+enum class TernaryStatus
+{
+    Ok,
+    InvalidDigit,
+    Overflow
+};
+
+struct TernaryLimit
+{
+    uint64_t value;      // largest value which can be multiplied by 3^n
+    uint64_t lastDigits; // largest n digits which can be added after multiplying s_limit by 3^n
+};
+
+constexpr TernaryLimit MakeTernaryLimit(uint64_t base)
+{
+    return TernaryLimit{std::numeric_limits<uint64_t>::max() / base, std::numeric_limits<uint64_t>::max() % base};
+}
+
+static const uint64_t s_powersOf3[9] = {1, 3, 9, 27, 81, 243, 729, 2187, 6561};
+static const TernaryLimit s_ternaryLimits[9] = {
+    MakeTernaryLimit(1), MakeTernaryLimit(3), MakeTernaryLimit(9), MakeTernaryLimit(27), MakeTernaryLimit(81),
+    MakeTernaryLimit(243), MakeTernaryLimit(729), MakeTernaryLimit(2187), MakeTernaryLimit(6561)
+};
+
+static const uint64_t s_ones = 0x0101010101010101ull;
+static const uint64_t s_highBits = 0x8080808080808080ull;
+
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define TERNARY_SWAR
+#endif
+
+// Returns true if all eight bytes are in '0'..'2'
+inline bool IsTernaryChunk(uint64_t chunk)
+{
+    return ((chunk - s_ones * '0') | (chunk + s_ones * (0x80 - '3')) | chunk) & s_highBits ? false : true;
+}
+
+// Converts eight ternary digits (one per byte, the first digit in the lowest byte) to their value
+inline uint64_t TernaryChunkValue(uint64_t digits)
+{
+    digits = ((digits * (1 + (3ull << 8))) >> 8) & 0x00FF00FF00FF00FFull;
+    digits = ((digits * (1 + (9ull << 16))) >> 16) & 0x0000FFFF0000FFFFull;
+    return (digits * (1 + (81ull << 32))) >> 32;
+}
+
+// value = value * 3^digitCount + digits, returns false instead of wrapping around
+inline bool AccumulateTernary(uint64_t& value, size_t digitCount, uint64_t digits)
+{
+    const TernaryLimit& limit = s_ternaryLimits[digitCount];
+    if (value > limit.value || (value == limit.value && digits > limit.lastDigits))
+    {
+        return false;
+    }
+    value = value * s_powersOf3[digitCount] + digits;
+    return true;
+}
+
+TernaryStatus ParseTernary(const char* ternary, size_t size, uint64_t& value)
+{
+    uint64_t result = 0;
+    // Overflow is reported only when there are no invalid digits further on
+    bool overflow = false;
+    size_t i = 0;
+#ifdef TERNARY_SWAR
+    if (size >= 8)
+    {
+        uint64_t chunk;
+        for (; i + 8 <= size; i += 8)
+        {
+            std::memcpy(&chunk, ternary + i, sizeof(chunk));
+            if (!IsTernaryChunk(chunk))
+            {
+                return TernaryStatus::InvalidDigit;
+            }
+            overflow = overflow || !AccumulateTernary(result, 8, TernaryChunkValue(chunk - s_ones * '0'));
+        }
+        if (i < size)
+        {
+            const size_t digitCount = size - i;
+            std::memcpy(&chunk, ternary + size - 8, sizeof(chunk));
+            if (!IsTernaryChunk(chunk))
+            {
+                return TernaryStatus::InvalidDigit;
+            }
+            // The tail is in the highest bytes, the lower ones turn into leading zeros
+            const uint64_t digits = (chunk - s_ones * '0') & (~0ull << (8 * (8 - digitCount)));
+            overflow = overflow || !AccumulateTernary(result, digitCount, TernaryChunkValue(digits));
+            i = size;
+        }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        const uint64_t digit = static_cast<unsigned char>(ternary[i]) - static_cast<uint64_t>('0');
+        if (digit > 2)
+        {
+            return TernaryStatus::InvalidDigit;
+        }
+        overflow = overflow || !AccumulateTernary(result, 1, digit);
+    }
+    if (overflow)
+    {
+        return TernaryStatus::Overflow;
+    }
+    value = result;
+    return TernaryStatus::Ok;
+}
+
+uint64_t TernaryToDecimal(const std::string& ternary)
+{
+    uint64_t value = 0;
+    if (ParseTernary(ternary.data(), ternary.size(), value) != TernaryStatus::Ok)
+    {
+        return 0;
+    }
+    return value;
+}
+
+// Per character reference implementation
+uint64_t TernaryToDecimalNaive(const char* ternary, size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        if (ternary[i] < '0' || ternary[i] > '2')
+        {
+            return 0;
+        }
+        value = value * 3 + static_cast<uint64_t>(ternary[i] - '0');
+    }
+    return value;
+}
+
+TEST(Ternary, Empty)
+{
+    ASSERT_EQ(0u, TernaryToDecimal(""));
+}
+
+TEST(Ternary, SingleDigit)
+{
+    ASSERT_EQ(0u, TernaryToDecimal("0"));
+    ASSERT_EQ(1u, TernaryToDecimal("1"));
+    ASSERT_EQ(2u, TernaryToDecimal("2"));
+}
+
+TEST(Ternary, Example)
+{
+    ASSERT_EQ(302u, TernaryToDecimal("102012"));
+}
+
+TEST(Ternary, InvalidDigit)
+{
+    ASSERT_EQ(0u, TernaryToDecimal("3"));
+    ASSERT_EQ(0u, TernaryToDecimal("1020a12"));
+    ASSERT_EQ(0u, TernaryToDecimal(" 102012"));
+}
+
+TEST(Ternary, InvalidDigitInChunk)
+{
+    for (size_t position = 0; position < 17; ++position)
+    {
+        for (char invalid : {'/', '3', ' ', '\0', '\x80', '\xB2', '\xFF'})
+        {
+            std::string ternary(17, '1');
+            ternary[position] = invalid;
+            uint64_t value = 42;
+            ASSERT_EQ(TernaryStatus::InvalidDigit, ParseTernary(ternary.data(), ternary.size(), value)) << position;
+            ASSERT_EQ(42u, value);
+        }
+    }
+}
+
+TEST(Ternary, ChunkAndTail)
+{
+    ASSERT_EQ(6560u, TernaryToDecimal("22222222"));
+    ASSERT_EQ(6561u, TernaryToDecimal("100000000"));
+    ASSERT_EQ(3280u * 6561u + 3280u, TernaryToDecimal("1111111111111111"));
+}
+
+TEST(Ternary, MatchesNaive)
+{
+    uint32_t seed = 12345;
+    for (size_t length = 0; length <= 40; ++length)
+    {
+        for (int sample = 0; sample < 100; ++sample)
+        {
+            std::string ternary;
+            for (size_t i = 0; i < length; ++i)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                ternary += static_cast<char>('0' + (seed >> 16) % 3);
+            }
+            ASSERT_EQ(TernaryToDecimalNaive(ternary.data(), ternary.size()), TernaryToDecimal(ternary)) << ternary;
+        }
+    }
+}
+
+TEST(Ternary, LargestValue)
+{
+    // 2^64 - 1 in ternary
+    const std::string ternary = "11112220022122120101211020120210210211220";
+    uint64_t value = 0;
+    ASSERT_EQ(TernaryStatus::Ok, ParseTernary(ternary.data(), ternary.size(), value));
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(), value);
+}
+
+TEST(Ternary, Overflow)
+{
+    // 2^64 in ternary
+    const std::string ternary = "11112220022122120101211020120210210211221";
+    uint64_t value = 42;
+    ASSERT_EQ(TernaryStatus::Overflow, ParseTernary(ternary.data(), ternary.size(), value));
+    ASSERT_EQ(42u, value);
+    ASSERT_EQ(0u, TernaryToDecimal(ternary));
+    ASSERT_EQ(0u, TernaryToDecimal(std::string(64, '2')));
+}
+
+TEST(Ternary, LeadingZerosDoNotOverflow)
+{
+    ASSERT_EQ(302u, TernaryToDecimal(std::string(100, '0') + "102012"));
+}
+
+TEST(Ternary, InvalidDigitAfterOverflow)
+{
+    const std::string ternary = std::string(64, '2') + "3";
+    uint64_t value = 0;
+    ASSERT_EQ(TernaryStatus::InvalidDigit, ParseTernary(ternary.data(), ternary.size(), value));
+}
+
+TEST(TernaryBenchmark, DISABLED_ParseVersusNaive)
+{
+    // Telemetry records of 16..40 digits stored back to back
+    std::string telemetry;
+    std::vector<size_t> offsets(1, 0);
+    uint32_t seed = 12345;
+    while (telemetry.size() < (64 << 20))
+    {
+        seed = seed * 1664525u + 1013904223u;
+        const size_t length = 16 + (seed >> 16) % 25;
+        for (size_t i = 0; i < length; ++i)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            telemetry += static_cast<char>('0' + (seed >> 16) % 3);
+        }
+        offsets.push_back(telemetry.size());
+    }
+    const size_t count = offsets.size() - 1;
+
+    uint64_t naiveSum = 0;
+    const auto naiveStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        naiveSum += TernaryToDecimalNaive(telemetry.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    const auto naiveTime = std::chrono::steady_clock::now() - naiveStart;
+
+    uint64_t swarSum = 0;
+    const auto swarStart = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t value = 0;
+        ParseTernary(telemetry.data() + offsets[i], offsets[i + 1] - offsets[i], value);
+        swarSum += value;
+    }
+    const auto swarTime = std::chrono::steady_clock::now() - swarStart;
+
+    ASSERT_EQ(naiveSum, swarSum);
+    std::cout << "naive: " << telemetry.size() / std::chrono::duration<double, std::micro>(naiveTime).count() << " MB/s, "
+              << "swar: " << telemetry.size() / std::chrono::duration<double, std::micro>(swarTime).count() << " MB/s" << std::endl;
+    EXPECT_LT(swarTime, naiveTime);
+}
@@ -4,6 +4,17 @@ TEMPLATE = app
 CONFIG += console c++11
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 SOURCES += \
-    test.cpp
+    test.cpp \
+    weather.cpp \
+    weatherasync.cpp \
+    weatherclient.cpp \
+    weatherrange.cpp
+
+HEADERS += \
+    weather.h \
+    weatherasync.h \
+    weatherclient.h \
+    weatherrange.h
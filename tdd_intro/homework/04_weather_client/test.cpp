@@ -44,38 +44,730 @@ IMPORTANT:
 2. Implement IWeatherClient using fake server.
 */
 
+#include "weather.h"
+#include "weatherasync.h"
+#include "weatherclient.h"
+#include "weatherrange.h"
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
-struct Weather
+/*
+ * Architecture:
+ * FakeWeatherServer answers the recorded responses above and counts the requests.
+ * ParseWeather turns a response into Weather without allocating, DayWeather holds the four times of a date.
+ * CachingWeatherClient fetches a date once into an LRU cache and answers every statistic from it.
+ * FetchRangeStatistics fetches the dates of a range in parallel and aggregates them per day and in total.
+ * DelayedWeatherServer answers synchronously or asynchronously after an injected latency, to measure how
+ * PipelinedWeatherServer keeps a bounded window of requests in flight from one thread.
+*/
+
+class FakeWeatherServer: public IWeatherServer
 {
-    short temperature = 0;
-    unsigned short windDirection = 0;
-    double windSpeed = 0;
-    bool operator==(const Weather& right)
+public:
+    virtual std::string GetWeather(const std::string& request) override
+    {
+        ++m_requests;
+        static const std::map<std::string, std::string> s_responses = {
+            {"31.08.2018;03:00", "20;181;5.1"},
+            {"31.08.2018;09:00", "23;204;4.9"},
+            {"31.08.2018;15:00", "33;193;4.3"},
+            {"31.08.2018;21:00", "26;179;4.5"},
+            {"01.09.2018;03:00", "19;176;4.2"},
+            {"01.09.2018;09:00", "22;131;4.1"},
+            {"01.09.2018;15:00", "31;109;4.0"},
+            {"01.09.2018;21:00", "24;127;4.1"},
+            {"02.09.2018;03:00", "21;158;3.8"},
+            {"02.09.2018;09:00", "25;201;3.5"},
+            {"02.09.2018;15:00", "34;258;3.7"},
+            {"02.09.2018;21:00", "27;299;4.0"}};
+        auto response = s_responses.find(request);
+        return response == s_responses.end() ? std::string() : response->second;
+    }
+
+    size_t Requests() const
     {
-        return temperature == right.temperature &&
-               windDirection == right.windDirection &&
-               std::abs(windSpeed - right.windSpeed) < 0.01;
+        return m_requests;
     }
+
+private:
+    std::atomic<size_t> m_requests{0};
 };
 
-class IWeatherServer
+TEST(FakeWeatherServer, RecordedResponses)
+{
+    FakeWeatherServer server;
+    ASSERT_EQ("20;181;5.1", server.GetWeather("31.08.2018;03:00"));
+    ASSERT_EQ("27;299;4.0", server.GetWeather("02.09.2018;21:00"));
+    ASSERT_EQ("", server.GetWeather("31.08.2018;04:00"));
+    ASSERT_EQ("", server.GetWeather("03.09.2018;03:00"));
+    ASSERT_EQ(4u, server.Requests());
+}
+
+TEST(ParseWeather, ValidResponses)
+{
+    Weather weather;
+    ASSERT_TRUE(ParseWeather("20;181;5.1", weather));
+    Weather expected;
+    expected.temperature = 20;
+    expected.windDirection = 181;
+    expected.windSpeed = 5.1;
+    ASSERT_TRUE(expected == weather);
+
+    ASSERT_TRUE(ParseWeather("-15;0;0", weather));
+    ASSERT_EQ(-15, weather.temperature);
+    ASSERT_EQ(0, weather.windDirection);
+    ASSERT_TRUE(ParseWeather("0;359;12.25", weather));
+    ASSERT_EQ(359, weather.windDirection);
+    ASSERT_DOUBLE_EQ(12.25, weather.windSpeed);
+}
+
+TEST(ParseWeather, InvalidResponses)
+{
+    Weather weather;
+    const char* responses[] = {"", "20;181", "20;181;5.1;1", "20;360;5.1", "20;-1;5.1", "x;181;5.1", "20;181;",
+                               "20;181;5.1x", ";181;5.1", "40000;181;5.1", "20;181;-1", "+20;181;5.1", " 20;181;5.1",
+                               "20 ;181;5.1", "-;181;5.1", "20;;5.1", "20;181;5.", "20;181;.5", "20;181;1e2",
+                               "20;181;nan", "20;181;5..1", "-32769;181;5.1", "20;99999999999999999999;5.1"};
+    for (const char* response : responses)
+    {
+        ASSERT_FALSE(ParseWeather(response, weather)) << response;
+    }
+}
+
+TEST(ParseWeather, Limits)
+{
+    Weather weather;
+    ASSERT_TRUE(ParseWeather("-32768;0;0.0", weather));
+    ASSERT_EQ(-32768, weather.temperature);
+    ASSERT_TRUE(ParseWeather("32767;359;007", weather));
+    ASSERT_EQ(32767, weather.temperature);
+    ASSERT_EQ(7, weather.windSpeed);
+    ASSERT_TRUE(ParseWeather("0;0;3.14159265358979323846", weather));
+    ASSERT_EQ(std::strtod("3.14159265358979323846", nullptr), weather.windSpeed);
+}
+
+TEST(ParseWeather, OnlyTheGivenSizeIsRead)
+{
+    Weather weather;
+    ASSERT_TRUE(ParseWeather("20;181;5.1;garbage", 10, weather));
+    ASSERT_DOUBLE_EQ(5.1, weather.windSpeed);
+    ASSERT_FALSE(ParseWeather("20;181;5.1", 7, weather));
+    ASSERT_FALSE(ParseWeather(nullptr, 0, weather));
+}
+
+namespace
+{
+    // Parser with standard streams, the reference of the allocation-free one
+    bool ParseWeatherNaive(const std::string& response, Weather& weather)
+    {
+        std::istringstream stream(response);
+        std::string fields[3];
+        for (std::string& field : fields)
+        {
+            if (!std::getline(stream, field, ';'))
+            {
+                return false;
+            }
+        }
+        if (!stream.eof() || response.back() == ';')
+        {
+            return false;
+        }
+        for (const std::string& field : fields)
+        {
+            if (field.empty() || field[0] == '+' || field[0] == ' ')
+            {
+                return false;
+            }
+        }
+        size_t parsed[3] = {};
+        long temperature = 0;
+        long direction = 0;
+        double speed = 0;
+        try
+        {
+            temperature = std::stol(fields[0], &parsed[0]);
+            direction = std::stol(fields[1], &parsed[1]);
+            speed = std::stod(fields[2], &parsed[2]);
+        }
+        catch (const std::logic_error&)
+        {
+            return false;
+        }
+        for (size_t field = 0; field < 3; ++field)
+        {
+            if (parsed[field] != fields[field].size())
+            {
+                return false;
+            }
+        }
+        if (temperature < -32768 || temperature > 32767 || direction < 0 || direction > 359 ||
+            fields[1][0] == '-' || fields[2][0] == '-' || fields[2][0] == '.' || fields[2].back() == '.' ||
+            fields[2].find_first_not_of("0123456789.") != std::string::npos)
+        {
+            return false;
+        }
+        weather.temperature = static_cast<short>(temperature);
+        weather.windDirection = static_cast<unsigned short>(direction);
+        weather.windSpeed = speed;
+        return true;
+    }
+
+    // Mostly valid responses in the format of the server, some of them with a broken character
+    std::vector<std::string> MakeResponses(size_t count)
+    {
+        std::vector<std::string> responses;
+        responses.reserve(count);
+        uint32_t seed = 1;
+        auto next = [&seed](uint32_t range)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            return (seed >> 8) % range;
+        };
+        const char broken[] = ";-.x 9";
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string response = std::to_string(static_cast<int>(next(100)) - 50) + ";" +
+                                   std::to_string(next(400)) + ";" + std::to_string(next(30)) + "." +
+                                   std::to_string(next(10));
+            if (next(10) == 0)
+            {
+                response[next(static_cast<uint32_t>(response.size()))] = broken[next(sizeof(broken) - 1)];
+            }
+            responses.push_back(response);
+        }
+        return responses;
+    }
+}
+
+TEST(ParseWeather, MatchesNaive)
+{
+    for (const std::string& response : MakeResponses(100000))
+    {
+        Weather weather;
+        Weather naive;
+        const bool valid = ParseWeather(response, weather);
+        ASSERT_EQ(ParseWeatherNaive(response, naive), valid) << response;
+        if (valid)
+        {
+            ASSERT_EQ(naive.temperature, weather.temperature) << response;
+            ASSERT_EQ(naive.windDirection, weather.windDirection) << response;
+            ASSERT_EQ(naive.windSpeed, weather.windSpeed) << response;
+        }
+    }
+}
+
+TEST(ParseWeatherBenchmark, DISABLED_MillionsOfResponses)
+{
+    const std::vector<std::string> responses = MakeResponses(1000000);
+    size_t bytes = 0;
+    for (const std::string& response : responses)
+    {
+        bytes += response.size();
+    }
+    const size_t repeats = 10;
+    Weather weather;
+
+    size_t valid = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        for (const std::string& response : responses)
+        {
+            valid += ParseWeather(response, weather);
+        }
+    }
+    auto time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "ParseWeather: " << repeats * responses.size() / time << " M responses/s, "
+              << repeats * bytes / time << " MB/s, " << valid / repeats << " valid" << std::endl;
+
+    valid = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t repeat = 0; repeat < repeats; ++repeat)
+    {
+        for (const std::string& response : responses)
+        {
+            valid += ParseWeatherNaive(response, weather);
+        }
+    }
+    time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "naive: " << repeats * responses.size() / time << " M responses/s, "
+              << repeats * bytes / time << " MB/s, " << valid / repeats << " valid" << std::endl;
+}
+
+TEST(WeatherClient, Statistics)
+{
+    FakeWeatherServer server;
+    CachingWeatherClient client(16);
+    ASSERT_DOUBLE_EQ(25.5, client.GetAverageTemperature(server, "31.08.2018"));
+    ASSERT_DOUBLE_EQ(20, client.GetMinimumTemperature(server, "31.08.2018"));
+    ASSERT_DOUBLE_EQ(33, client.GetMaximumTemperature(server, "31.08.2018"));
+    ASSERT_DOUBLE_EQ(189.25, client.GetAverageWindDirection(server, "31.08.2018"));
+    ASSERT_DOUBLE_EQ(5.1, client.GetMaximumWindSpeed(server, "31.08.2018"));
+
+    ASSERT_DOUBLE_EQ(24, client.GetAverageTemperature(server, "01.09.2018"));
+    ASSERT_DOUBLE_EQ(19, client.GetMinimumTemperature(server, "01.09.2018"));
+    ASSERT_DOUBLE_EQ(31, client.GetMaximumTemperature(server, "01.09.2018"));
+    ASSERT_DOUBLE_EQ(135.75, client.GetAverageWindDirection(server, "01.09.2018"));
+    ASSERT_DOUBLE_EQ(4.2, client.GetMaximumWindSpeed(server, "01.09.2018"));
+
+    ASSERT_DOUBLE_EQ(26.75, client.GetAverageTemperature(server, "02.09.2018"));
+    ASSERT_DOUBLE_EQ(21, client.GetMinimumTemperature(server, "02.09.2018"));
+    ASSERT_DOUBLE_EQ(34, client.GetMaximumTemperature(server, "02.09.2018"));
+    ASSERT_DOUBLE_EQ(229, client.GetAverageWindDirection(server, "02.09.2018"));
+    ASSERT_DOUBLE_EQ(4.0, client.GetMaximumWindSpeed(server, "02.09.2018"));
+}
+
+TEST(WeatherClient, OneFetchPerDate)
+{
+    FakeWeatherServer server;
+    CachingWeatherClient client(16);
+    client.GetAverageTemperature(server, "31.08.2018");
+    client.GetMinimumTemperature(server, "31.08.2018");
+    client.GetMaximumTemperature(server, "31.08.2018");
+    client.GetAverageWindDirection(server, "31.08.2018");
+    client.GetMaximumWindSpeed(server, "31.08.2018");
+    ASSERT_EQ(4u, server.Requests());
+    ASSERT_EQ(1u, client.Fetches());
+    ASSERT_EQ(4u, client.Hits());
+}
+
+TEST(WeatherClient, LeastRecentlyUsedIsEvicted)
+{
+    FakeWeatherServer server;
+    CachingWeatherClient client(2);
+    client.GetAverageTemperature(server, "31.08.2018");
+    client.GetAverageTemperature(server, "01.09.2018");
+    client.GetAverageTemperature(server, "31.08.2018");
+    // 01.09.2018 is the least recently used one now
+    client.GetAverageTemperature(server, "02.09.2018");
+    client.GetAverageTemperature(server, "31.08.2018");
+    ASSERT_EQ(3u, client.Fetches());
+    client.GetAverageTemperature(server, "01.09.2018");
+    ASSERT_EQ(4u, client.Fetches());
+    ASSERT_EQ(16u, server.Requests());
+}
+
+TEST(WeatherClient, ServersAreCachedApart)
+{
+    FakeWeatherServer first;
+    FakeWeatherServer second;
+    CachingWeatherClient client(16);
+    client.GetAverageTemperature(first, "31.08.2018");
+    client.GetAverageTemperature(second, "31.08.2018");
+    ASSERT_EQ(4u, first.Requests());
+    ASSERT_EQ(4u, second.Requests());
+}
+
+TEST(WeatherClient, InvalidDateIsNotCached)
+{
+    FakeWeatherServer server;
+    CachingWeatherClient client(16);
+    ASSERT_THROW(client.GetAverageTemperature(server, "03.09.2018"), std::runtime_error);
+    ASSERT_THROW(client.GetAverageTemperature(server, "03.09.2018"), std::runtime_error);
+    ASSERT_EQ(2u, client.Fetches());
+    ASSERT_THROW(CachingWeatherClient(0), std::invalid_argument);
+}
+
+// Holds every request until it is opened
+class GatedWeatherServer: public IWeatherServer
 {
 public:
-    virtual ~IWeatherServer() { }
-    // Returns raw response with weather for the given day and time in request
-    virtual std::string GetWeather(const std::string& request) = 0;
+    virtual std::string GetWeather(const std::string& request) override
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_open; });
+        ++m_requests;
+        return m_server.GetWeather(request);
+    }
+
+    void Open()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_open = true;
+        m_changed.notify_all();
+    }
+
+    size_t Requests()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_requests;
+    }
+
+private:
+    FakeWeatherServer m_server;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_open = false;
+    size_t m_requests = 0;
 };
 
-// Implement this interface
-class IWeatherClient
+TEST(WeatherClient, ConcurrentRequestsAreCoalesced)
+{
+    GatedWeatherServer server;
+    CachingWeatherClient client(16);
+    const size_t threadCount = 8;
+    std::vector<double> results(threadCount);
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < threadCount; ++thread)
+    {
+        threads.emplace_back([&, thread] { results[thread] = client.GetMaximumTemperature(server, "02.09.2018"); });
+    }
+    while (client.Fetches() + client.Coalesced() != threadCount)
+    {
+        std::this_thread::yield();
+    }
+    server.Open();
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    ASSERT_EQ(4u, server.Requests());
+    ASSERT_EQ(1u, client.Fetches());
+    ASSERT_EQ(threadCount - 1, client.Coalesced());
+    ASSERT_EQ(std::vector<double>(threadCount, 34), results);
+}
+
+TEST(DateRange, Dates)
+{
+    ASSERT_EQ(std::vector<std::string>({"31.08.2018", "01.09.2018", "02.09.2018"}),
+              DateRange("31.08.2018", "02.09.2018"));
+    ASSERT_EQ(std::vector<std::string>({"28.02.2020", "29.02.2020", "01.03.2020"}),
+              DateRange("28.02.2020", "01.03.2020"));
+    ASSERT_EQ(std::vector<std::string>({"28.02.2100", "01.03.2100"}), DateRange("28.02.2100", "01.03.2100"));
+    ASSERT_EQ(std::vector<std::string>({"31.12.2018", "01.01.2019"}), DateRange("31.12.2018", "01.01.2019"));
+    ASSERT_EQ(std::vector<std::string>({"01.09.2018"}), DateRange("01.09.2018", "01.09.2018"));
+    ASSERT_EQ(365u, DateRange("01.01.2018", "31.12.2018").size());
+}
+
+TEST(DateRange, InvalidDates)
+{
+    ASSERT_THROW(DateRange("02.09.2018", "01.09.2018"), std::invalid_argument);
+    ASSERT_THROW(DateRange("29.02.2018", "01.03.2018"), std::invalid_argument);
+    ASSERT_THROW(DateRange("31.09.2018", "01.10.2018"), std::invalid_argument);
+    ASSERT_THROW(DateRange("1.09.2018", "02.09.2018"), std::invalid_argument);
+    ASSERT_THROW(DateRange("01.13.2018", "02.09.2018"), std::invalid_argument);
+    ASSERT_THROW(DateRange("01.09.2018", "2018-09-02"), std::invalid_argument);
+}
+
+TEST(WeatherAccumulator, Statistics)
+{
+    WeatherAccumulator accumulator;
+    ASSERT_EQ(0u, accumulator.Statistics().count);
+    const char* responses[] = {"20;350;5.1", "23;20;4.9", "33;350;4.3", "26;20;4.5"};
+    for (const char* response : responses)
+    {
+        Weather weather;
+        ASSERT_TRUE(ParseWeather(response, weather));
+        accumulator.Add(weather);
+    }
+    const WeatherStatistics statistics = accumulator.Statistics();
+    ASSERT_EQ(4u, statistics.count);
+    ASSERT_DOUBLE_EQ(20, statistics.minimumTemperature);
+    ASSERT_DOUBLE_EQ(33, statistics.maximumTemperature);
+    ASSERT_DOUBLE_EQ(25.5, statistics.averageTemperature);
+    ASSERT_DOUBLE_EQ(23.25, statistics.temperatureVariance);
+    ASSERT_NEAR(5, statistics.averageWindDirection, 1e-9);
+    ASSERT_DOUBLE_EQ(5.1, statistics.maximumWindSpeed);
+}
+
+TEST(WeatherAccumulator, OppositeDirectionsCancelOut)
+{
+    const unsigned short pairs[][2] = {{0, 180}, {90, 270}, {45, 225}, {1, 181}, {359, 179}};
+    for (const auto& pair : pairs)
+    {
+        WeatherAccumulator accumulator;
+        for (size_t repeat = 0; repeat < 3; ++repeat)
+        {
+            for (unsigned short direction : pair)
+            {
+                Weather weather;
+                weather.windDirection = direction;
+                accumulator.Add(weather);
+            }
+        }
+        ASSERT_EQ(0, accumulator.Statistics().averageWindDirection) << pair[0] << " and " << pair[1];
+    }
+}
+
+TEST(WeatherAccumulator, MergeMatchesAdd)
+{
+    WeatherAccumulator all;
+    WeatherAccumulator parts[3];
+    uint32_t seed = 7;
+    for (size_t i = 0; i < 300; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        Weather weather;
+        weather.temperature = static_cast<short>(static_cast<int>(seed >> 24) - 128);
+        weather.windDirection = static_cast<unsigned short>((seed >> 8) % 360);
+        weather.windSpeed = (seed & 0xff) / 10.0;
+        all.Add(weather);
+        parts[i % 7 % 3].Add(weather);
+    }
+    WeatherAccumulator merged;
+    merged.Merge(WeatherAccumulator());
+    for (const WeatherAccumulator& part : parts)
+    {
+        merged.Merge(part);
+    }
+    const WeatherStatistics expected = all.Statistics();
+    const WeatherStatistics statistics = merged.Statistics();
+    ASSERT_EQ(expected.count, statistics.count);
+    ASSERT_EQ(expected.minimumTemperature, statistics.minimumTemperature);
+    ASSERT_EQ(expected.maximumTemperature, statistics.maximumTemperature);
+    ASSERT_NEAR(expected.averageTemperature, statistics.averageTemperature, 1e-9);
+    ASSERT_NEAR(expected.temperatureVariance, statistics.temperatureVariance, 1e-9);
+    ASSERT_NEAR(expected.averageWindDirection, statistics.averageWindDirection, 1e-9);
+    ASSERT_EQ(expected.maximumWindSpeed, statistics.maximumWindSpeed);
+}
+
+TEST(RangeStatistics, RecordedDates)
+{
+    for (size_t parallelism : {1, 2, 8})
+    {
+        FakeWeatherServer server;
+        const RangeStatistics range = FetchRangeStatistics(server, "31.08.2018", "02.09.2018", parallelism);
+        ASSERT_EQ(12u, server.Requests());
+        ASSERT_EQ(12u, range.total.count);
+        ASSERT_DOUBLE_EQ(19, range.total.minimumTemperature);
+        ASSERT_DOUBLE_EQ(34, range.total.maximumTemperature);
+        ASSERT_DOUBLE_EQ(305.0 / 12, range.total.averageTemperature);
+        ASSERT_DOUBLE_EQ(5.1, range.total.maximumWindSpeed);
+
+        ASSERT_EQ(3u, range.days.size());
+        CachingWeatherClient client(16);
+        for (const DayStatistics& day : range.days)
+        {
+            ASSERT_EQ(4u, day.statistics.count);
+            ASSERT_DOUBLE_EQ(client.GetAverageTemperature(server, day.date), day.statistics.averageTemperature);
+            ASSERT_DOUBLE_EQ(client.GetMinimumTemperature(server, day.date), day.statistics.minimumTemperature);
+            ASSERT_DOUBLE_EQ(client.GetMaximumTemperature(server, day.date), day.statistics.maximumTemperature);
+            ASSERT_DOUBLE_EQ(client.GetMaximumWindSpeed(server, day.date), day.statistics.maximumWindSpeed);
+        }
+        ASSERT_EQ("31.08.2018", range.days[0].date);
+        ASSERT_EQ("02.09.2018", range.days[2].date);
+    }
+}
+
+TEST(RangeStatistics, InvalidResponseThrows)
+{
+    FakeWeatherServer server;
+    ASSERT_THROW(FetchRangeStatistics(server, "01.09.2018", "03.09.2018", 2), std::runtime_error);
+    ASSERT_THROW(FetchRangeStatistics(server, "01.09.2018", "02.09.2018", 0), std::invalid_argument);
+    ASSERT_THROW(FetchRangeStatistics(server, "02.09.2018", "01.09.2018", 1), std::invalid_argument);
+}
+
+// Answers every request of a valid date, so ranges of any length can be fetched
+class SyntheticWeatherServer: public IWeatherServer
+{
+public:
+    virtual std::string GetWeather(const std::string& request) override
+    {
+        const size_t hash = std::hash<std::string>()(request);
+        return std::to_string(static_cast<int>(hash % 50) - 20) + ";" + std::to_string(hash / 50 % 360) + ";" +
+               std::to_string(hash / 18000 % 20) + "." + std::to_string(hash / 360000 % 10);
+    }
+};
+
+// Answers the requests of source after latency: GetWeather sleeps, GetWeatherAsync calls back from a
+// delivery thread
+class DelayedWeatherServer: public IWeatherServer, public IAsyncWeatherServer
+{
+public:
+    DelayedWeatherServer(IWeatherServer& source, std::chrono::microseconds latency)
+        : m_source(source)
+        , m_latency(latency)
+        , m_sequence(0)
+        , m_maxInFlight(0)
+        , m_stop(false)
+        , m_thread(&DelayedWeatherServer::Deliver, this)
+    {
+    }
+
+    ~DelayedWeatherServer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_changed.notify_all();
+        m_thread.join();
+    }
+
+    virtual std::string GetWeather(const std::string& request) override
+    {
+        std::this_thread::sleep_for(m_latency);
+        return m_source.GetWeather(request);
+    }
+
+    virtual void GetWeatherAsync(const std::string& request, Callback callback) override
+    {
+        std::string response = m_source.GetWeather(request);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Key key(std::chrono::steady_clock::now() + m_latency, m_sequence++);
+        m_pending.emplace(key, Pending{std::move(response), std::move(callback)});
+        m_maxInFlight = std::max(m_maxInFlight, m_pending.size());
+        m_changed.notify_all();
+    }
+
+    size_t MaxInFlight()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_maxInFlight;
+    }
+
+private:
+    typedef std::pair<std::chrono::steady_clock::time_point, size_t> Key;
+
+    struct Pending
+    {
+        std::string response;
+        Callback callback;
+    };
+
+    void Deliver()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop)
+        {
+            if (m_pending.empty())
+            {
+                m_changed.wait(lock);
+                continue;
+            }
+            const auto first = m_pending.begin();
+            if (first->first.first > std::chrono::steady_clock::now())
+            {
+                m_changed.wait_until(lock, first->first.first);
+                continue;
+            }
+            Pending pending = std::move(first->second);
+            m_pending.erase(first);
+            lock.unlock();
+            pending.callback(pending.response);
+            lock.lock();
+        }
+    }
+
+    IWeatherServer& m_source;
+    const std::chrono::microseconds m_latency;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::map<Key, Pending> m_pending;
+    size_t m_sequence;
+    size_t m_maxInFlight;
+    bool m_stop;
+    std::thread m_thread;
+};
+
+TEST(PipelinedWeatherServer, WindowBoundsRequestsInFlight)
+{
+    FakeWeatherServer source;
+    DelayedWeatherServer server(source, std::chrono::milliseconds(2));
+    PipelinedWeatherServer pipeline(server, 3);
+    std::vector<std::future<std::string>> responses;
+    for (size_t repeat = 0; repeat < 5; ++repeat)
+    {
+        for (const char* time : DayWeather::s_times)
+        {
+            responses.push_back(pipeline.Request(std::string("31.08.2018;") + time));
+        }
+    }
+    for (size_t response = 0; response < responses.size(); ++response)
+    {
+        ASSERT_EQ(source.GetWeather(std::string("31.08.2018;") + DayWeather::s_times[response % 4]),
+                  responses[response].get());
+    }
+    ASSERT_LE(server.MaxInFlight(), 3u);
+    ASSERT_GT(server.MaxInFlight(), 1u);
+    ASSERT_EQ(3u, pipeline.Window());
+    ASSERT_THROW(PipelinedWeatherServer(server, 0), std::invalid_argument);
+}
+
+// Calls back before GetWeatherAsync returns
+class ImmediateWeatherServer: public IAsyncWeatherServer
 {
 public:
-    virtual ~IWeatherClient() { }
-    virtual double GetAverageTemperature(IWeatherServer& server, const std::string& date) = 0;
-    virtual double GetMinimumTemperature(IWeatherServer& server, const std::string& date) = 0;
-    virtual double GetMaximumTemperature(IWeatherServer& server, const std::string& date) = 0;
-    virtual double GetAverageWindDirection(IWeatherServer& server, const std::string& date) = 0;
-    virtual double GetMaximumWindSpeed(IWeatherServer& server, const std::string& date) = 0;
+    virtual void GetWeatherAsync(const std::string& request, Callback callback) override
+    {
+        callback(m_server.GetWeather(request));
+    }
+
+private:
+    FakeWeatherServer m_server;
 };
+
+TEST(PipelinedWeatherServer, SynchronousClientsRunOverIt)
+{
+    ImmediateWeatherServer server;
+    PipelinedWeatherServer pipeline(server, 1);
+    ASSERT_EQ("20;181;5.1", pipeline.GetWeather("31.08.2018;03:00"));
+    CachingWeatherClient client(16);
+    ASSERT_DOUBLE_EQ(25.5, client.GetAverageTemperature(pipeline, "31.08.2018"));
+}
+
+TEST(PipelinedWeatherServer, RangeStatisticsMatchThreaded)
+{
+    SyntheticWeatherServer source;
+    DelayedWeatherServer server(source, std::chrono::microseconds(100));
+    PipelinedWeatherServer pipeline(server, 8);
+    const RangeStatistics pipelined = FetchRangeStatistics(pipeline, "20.02.2016", "10.03.2016");
+    const RangeStatistics threaded = FetchRangeStatistics(source, "20.02.2016", "10.03.2016", 4);
+    ASSERT_EQ(20u, pipelined.days.size());
+    ASSERT_EQ(threaded.total.count, pipelined.total.count);
+    ASSERT_EQ(threaded.total.averageTemperature, pipelined.total.averageTemperature);
+    ASSERT_EQ(threaded.total.averageWindDirection, pipelined.total.averageWindDirection);
+    ASSERT_EQ(threaded.total.maximumWindSpeed, pipelined.total.maximumWindSpeed);
+    for (size_t day = 0; day < pipelined.days.size(); ++day)
+    {
+        ASSERT_EQ(threaded.days[day].date, pipelined.days[day].date);
+        ASSERT_EQ(threaded.days[day].statistics.minimumTemperature, pipelined.days[day].statistics.minimumTemperature);
+    }
+
+    FakeWeatherServer recorded;
+    DelayedWeatherServer delayed(recorded, std::chrono::microseconds(100));
+    PipelinedWeatherServer recordedPipeline(delayed, 8);
+    ASSERT_THROW(FetchRangeStatistics(recordedPipeline, "01.09.2018", "03.09.2018"), std::runtime_error);
+}
+
+TEST(PipelinedWeatherServerBenchmark, DISABLED_MonthOfStatistics)
+{
+    SyntheticWeatherServer source;
+    DelayedWeatherServer server(source, std::chrono::milliseconds(1));
+    auto measure = [](const std::string& name, std::function<RangeStatistics()> fetch, double baseline)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const RangeStatistics range = fetch();
+        const double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << name << ": " << range.total.count << " requests in " << time << " ms";
+        if (baseline > 0)
+        {
+            std::cout << ", " << baseline / time << "x";
+        }
+        std::cout << std::endl;
+        return time;
+    };
+
+    const double sync = measure("sync", [&] { return FetchRangeStatistics(server, "01.01.2018", "30.01.2018", 1); }, 0);
+    measure("8 threads", [&] { return FetchRangeStatistics(server, "01.01.2018", "30.01.2018", 8); }, sync);
+    for (size_t window : {1, 4, 16, 64})
+    {
+        PipelinedWeatherServer pipeline(server, window);
+        measure("window " + std::to_string(window),
+                [&] { return FetchRangeStatistics(pipeline, "01.01.2018", "30.01.2018"); }, sync);
+    }
+}
@@ -0,0 +1,119 @@
+#include "weather.h"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // Powers of ten a double holds exactly
+    const double s_powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    // Digits an integer below 2^53 always has room for, so the fast path converts exactly
+    const size_t s_exactDigits = 15;
+    // Longest speed the strtod fallback copies to the stack
+    const size_t s_maxSpeedLength = 64;
+
+    bool IsDigit(char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // Parses [-]digits up to separator or end like std::from_chars, false when nothing is parsed or the
+    // value leaves [minimum, maximum]
+    bool ParseInteger(const char*& current, const char* end, long minimum, long maximum, long& value)
+    {
+        const bool negative = current != end && *current == '-' && minimum < 0;
+        const char* digits = negative ? current + 1 : current;
+        const long limit = negative ? -minimum : maximum;
+        long magnitude = 0;
+        const char* position = digits;
+        for (; position != end && IsDigit(*position); ++position)
+        {
+            magnitude = magnitude * 10 + (*position - '0');
+            if (magnitude > limit)
+            {
+                return false;
+            }
+        }
+        if (position == digits)
+        {
+            return false;
+        }
+        value = negative ? -magnitude : magnitude;
+        current = position;
+        return true;
+    }
+
+    // Parses digits[.digits] up to end, no sign, exponent or special values
+    bool ParseSpeed(const char* begin, const char* end, double& value)
+    {
+        uint64_t mantissa = 0;
+        size_t digits = 0;
+        size_t fractionDigits = 0;
+        const char* position = begin;
+        for (; position != end && IsDigit(*position); ++position, ++digits)
+        {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+        }
+        const size_t integerDigits = digits;
+        const bool point = position != end && *position == '.';
+        if (point)
+        {
+            for (++position; position != end && IsDigit(*position); ++position, ++digits, ++fractionDigits)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+            }
+        }
+        if (position != end || integerDigits == 0 || (point && fractionDigits == 0))
+        {
+            return false;
+        }
+        if (digits <= s_exactDigits)
+        {
+            // Both operands are exact, so the quotient is rounded once like strtod rounds
+            value = static_cast<double>(mantissa) / s_powersOfTen[fractionDigits];
+            return true;
+        }
+        // Too many digits to convert exactly: strtod on a copy with a terminator, still on the stack
+        const size_t length = static_cast<size_t>(end - begin);
+        if (length >= s_maxSpeedLength)
+        {
+            return false;
+        }
+        char copy[s_maxSpeedLength];
+        std::memcpy(copy, begin, length);
+        copy[length] = '\0';
+        value = std::strtod(copy, nullptr);
+        return true;
+    }
+}
+
+bool ParseWeather(const char* response, size_t size, Weather& weather)
+{
+    const char* current = response;
+    const char* end = response + size;
+    long temperature = 0;
+    long direction = 0;
+    if (!ParseInteger(current, end, std::numeric_limits<short>::min(), std::numeric_limits<short>::max(), temperature) ||
+        current == end || *current++ != ';' ||
+        !ParseInteger(current, end, 0, 359, direction) ||
+        current == end || *current++ != ';')
+    {
+        return false;
+    }
+    double speed = 0;
+    if (!ParseSpeed(current, end, speed))
+    {
+        return false;
+    }
+    weather.temperature = static_cast<short>(temperature);
+    weather.windDirection = static_cast<unsigned short>(direction);
+    weather.windSpeed = speed;
+    return true;
+}
+
+bool ParseWeather(const std::string& response, Weather& weather)
+{
+    return ParseWeather(response.data(), response.size(), weather);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+/*
+ * Weather server interfaces of the exercise and the parsing of its responses.
+ *
+ * A response is "<air_temperature_in_celsius>;<wind_direction_in_degrees>;<wind_speed>", for example "20;181;5.1".
+ * The server answers an invalid request with an empty string.
+*/
+
+struct Weather
+{
+    short temperature = 0;
+    unsigned short windDirection = 0;
+    double windSpeed = 0;
+    bool operator==(const Weather& right)
+    {
+        return temperature == right.temperature &&
+               windDirection == right.windDirection &&
+               std::abs(windSpeed - right.windSpeed) < 0.01;
+    }
+};
+
+class IWeatherServer
+{
+public:
+    virtual ~IWeatherServer() { }
+    // Returns raw response with weather for the given day and time in request
+    virtual std::string GetWeather(const std::string& request) = 0;
+};
+
+// Implement this interface
+class IWeatherClient
+{
+public:
+    virtual ~IWeatherClient() { }
+    virtual double GetAverageTemperature(IWeatherServer& server, const std::string& date) = 0;
+    virtual double GetMinimumTemperature(IWeatherServer& server, const std::string& date) = 0;
+    virtual double GetMaximumTemperature(IWeatherServer& server, const std::string& date) = 0;
+    virtual double GetAverageWindDirection(IWeatherServer& server, const std::string& date) = 0;
+    virtual double GetMaximumWindSpeed(IWeatherServer& server, const std::string& date) = 0;
+};
+
+// Returns false when the response is empty or malformed, or a value is out of range.
+// Numbers are read like std::from_chars: no spaces, no '+', a speed has no exponent. Nothing is allocated.
+bool ParseWeather(const char* response, size_t size, Weather& weather);
+bool ParseWeather(const std::string& response, Weather& weather);
@@ -0,0 +1,95 @@
+#include "weatherasync.h"
+#include "weatherclient.h"
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+PipelinedWeatherServer::PipelinedWeatherServer(IAsyncWeatherServer& server, size_t window)
+    : m_server(server)
+    , m_window(window)
+    , m_inFlight(0)
+{
+    if (window == 0)
+    {
+        throw std::invalid_argument("Pipeline window must be positive");
+    }
+}
+
+PipelinedWeatherServer::~PipelinedWeatherServer()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_released.wait(lock, [this] { return m_inFlight == 0; });
+}
+
+std::future<std::string> PipelinedWeatherServer::Request(const std::string& request)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [this] { return m_inFlight < m_window; });
+        ++m_inFlight;
+    }
+    // Shared because std::function copies the callback
+    auto promise = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> response = promise->get_future();
+    try
+    {
+        // The lock is not held: the server may call back right here
+        m_server.GetWeatherAsync(request, [this, promise](const std::string& answer)
+        {
+            // Released first: once the promise is set the owner may destroy the pipeline
+            Release();
+            promise->set_value(answer);
+        });
+    }
+    catch (...)
+    {
+        Release();
+        throw;
+    }
+    return response;
+}
+
+std::string PipelinedWeatherServer::GetWeather(const std::string& request)
+{
+    return Request(request).get();
+}
+
+size_t PipelinedWeatherServer::Window() const
+{
+    return m_window;
+}
+
+void PipelinedWeatherServer::Release()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_inFlight;
+    m_released.notify_all();
+}
+
+RangeStatistics FetchRangeStatistics(PipelinedWeatherServer& server, const std::string& first,
+                                     const std::string& last)
+{
+    const std::vector<std::string> dates = DateRange(first, last);
+    std::vector<std::future<std::string>> responses;
+    responses.reserve(dates.size() * DayWeather::s_timeCount);
+    for (const std::string& date : dates)
+    {
+        for (const char* time : DayWeather::s_times)
+        {
+            responses.push_back(server.Request(date + ";" + time));
+        }
+    }
+
+    std::vector<DayWeather> days(dates.size());
+    for (size_t response = 0; response < responses.size(); ++response)
+    {
+        const size_t day = response / DayWeather::s_timeCount;
+        const size_t time = response % DayWeather::s_timeCount;
+        if (!ParseWeather(responses[response].get(), days[day].weather[time]))
+        {
+            throw std::runtime_error("Invalid weather response for " + dates[day] + ";" + DayWeather::s_times[time]);
+        }
+    }
+    return AggregateRange(dates, days);
+}
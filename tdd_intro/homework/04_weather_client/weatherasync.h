@@ -0,0 +1,65 @@
+#pragma once
+#include "weather.h"
+#include "weatherrange.h"
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+
+/*
+ * Asynchronous weather server and a client side pipeline over it.
+ *
+ * IAsyncWeatherServer takes a request and calls back with the response later, so one thread can have
+ * many requests on the wire instead of waiting a round trip for each of them.
+ * PipelinedWeatherServer bounds the requests in flight: Request blocks while window of them wait for
+ * their responses, then sends the request and returns a future of the response. A caller pipelines by
+ * requesting everything it needs in order and reading the futures afterwards; the window gives it
+ * back-pressure so a slow server is not flooded.
+ * PipelinedWeatherServer is an IWeatherServer as well, so the synchronous clients run over an asynchronous
+ * server unchanged, one round trip per request.
+*/
+
+class IAsyncWeatherServer
+{
+public:
+    // Takes the raw response of the request, as IWeatherServer::GetWeather returns it
+    using Callback = std::function<void(const std::string& response)>;
+
+    virtual ~IAsyncWeatherServer() { }
+    // Calls callback once with the response, on any thread and possibly before returning
+    virtual void GetWeatherAsync(const std::string& request, Callback callback) = 0;
+};
+
+class PipelinedWeatherServer: public IWeatherServer
+{
+public:
+    // Throws std::invalid_argument for a zero window
+    PipelinedWeatherServer(IAsyncWeatherServer& server, size_t window);
+    // Waits for the responses in flight
+    ~PipelinedWeatherServer();
+    PipelinedWeatherServer(const PipelinedWeatherServer&) = delete;
+    PipelinedWeatherServer& operator=(const PipelinedWeatherServer&) = delete;
+
+    // Thread-safe, blocks while the window is full
+    std::future<std::string> Request(const std::string& request);
+    virtual std::string GetWeather(const std::string& request) override;
+
+    size_t Window() const;
+
+private:
+    void Release();
+
+    IAsyncWeatherServer& m_server;
+    const size_t m_window;
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    size_t m_inFlight;
+};
+
+// Requests the four times of every date from first to last through the pipeline and aggregates them like
+// the threaded FetchRangeStatistics, from the calling thread only. Throws std::invalid_argument for an
+// invalid range and std::runtime_error when a response is invalid.
+RangeStatistics FetchRangeStatistics(PipelinedWeatherServer& server, const std::string& first,
+                                     const std::string& last);
@@ -0,0 +1,187 @@
+#include "weatherclient.h"
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+
+const char* const DayWeather::s_times[DayWeather::s_timeCount] = {"03:00", "09:00", "15:00", "21:00"};
+
+DayWeather FetchDayWeather(IWeatherServer& server, const std::string& date)
+{
+    DayWeather day;
+    for (size_t time = 0; time < DayWeather::s_timeCount; ++time)
+    {
+        const std::string request = date + ";" + DayWeather::s_times[time];
+        if (!ParseWeather(server.GetWeather(request), day.weather[time]))
+        {
+            throw std::runtime_error("Invalid weather response for " + request);
+        }
+    }
+    return day;
+}
+
+double AverageTemperature(const DayWeather& day)
+{
+    double sum = 0;
+    for (const Weather& weather : day.weather)
+    {
+        sum += weather.temperature;
+    }
+    return sum / DayWeather::s_timeCount;
+}
+
+double MinimumTemperature(const DayWeather& day)
+{
+    short minimum = day.weather[0].temperature;
+    for (const Weather& weather : day.weather)
+    {
+        minimum = std::min(minimum, weather.temperature);
+    }
+    return minimum;
+}
+
+double MaximumTemperature(const DayWeather& day)
+{
+    short maximum = day.weather[0].temperature;
+    for (const Weather& weather : day.weather)
+    {
+        maximum = std::max(maximum, weather.temperature);
+    }
+    return maximum;
+}
+
+double AverageWindDirection(const DayWeather& day)
+{
+    double sum = 0;
+    for (const Weather& weather : day.weather)
+    {
+        sum += weather.windDirection;
+    }
+    return sum / DayWeather::s_timeCount;
+}
+
+double MaximumWindSpeed(const DayWeather& day)
+{
+    double maximum = day.weather[0].windSpeed;
+    for (const Weather& weather : day.weather)
+    {
+        maximum = std::max(maximum, weather.windSpeed);
+    }
+    return maximum;
+}
+
+size_t CachingWeatherClient::KeyHash::operator()(const Key& key) const
+{
+    return std::hash<std::string>()(key.second) ^ std::hash<IWeatherServer*>()(key.first);
+}
+
+CachingWeatherClient::CachingWeatherClient(size_t capacity)
+    : m_capacity(capacity)
+    , m_hits(0)
+    , m_fetches(0)
+    , m_coalesced(0)
+{
+    if (capacity == 0)
+    {
+        throw std::invalid_argument("Weather cache capacity must be positive");
+    }
+}
+
+double CachingWeatherClient::GetAverageTemperature(IWeatherServer& server, const std::string& date)
+{
+    return AverageTemperature(GetDayWeather(server, date));
+}
+
+double CachingWeatherClient::GetMinimumTemperature(IWeatherServer& server, const std::string& date)
+{
+    return MinimumTemperature(GetDayWeather(server, date));
+}
+
+double CachingWeatherClient::GetMaximumTemperature(IWeatherServer& server, const std::string& date)
+{
+    return MaximumTemperature(GetDayWeather(server, date));
+}
+
+double CachingWeatherClient::GetAverageWindDirection(IWeatherServer& server, const std::string& date)
+{
+    return AverageWindDirection(GetDayWeather(server, date));
+}
+
+double CachingWeatherClient::GetMaximumWindSpeed(IWeatherServer& server, const std::string& date)
+{
+    return MaximumWindSpeed(GetDayWeather(server, date));
+}
+
+DayWeather CachingWeatherClient::GetDayWeather(IWeatherServer& server, const std::string& date)
+{
+    const Key key(&server, date);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto cached = m_index.find(key);
+    if (cached != m_index.end())
+    {
+        ++m_hits;
+        m_entries.splice(m_entries.begin(), m_entries, cached->second);
+        return cached->second->day;
+    }
+    auto inFlight = m_inFlight.find(key);
+    if (inFlight != m_inFlight.end())
+    {
+        ++m_coalesced;
+        const std::shared_future<DayWeather> fetch = inFlight->second;
+        lock.unlock();
+        return fetch.get();
+    }
+    ++m_fetches;
+    std::promise<DayWeather> promise;
+    m_inFlight.emplace(key, promise.get_future().share());
+    lock.unlock();
+
+    try
+    {
+        const DayWeather day = FetchDayWeather(server, date);
+        lock.lock();
+        Insert(key, day);
+        m_inFlight.erase(key);
+        promise.set_value(day);
+        return day;
+    }
+    catch (...)
+    {
+        if (!lock.owns_lock())
+        {
+            lock.lock();
+        }
+        m_inFlight.erase(key);
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+size_t CachingWeatherClient::Hits() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_hits;
+}
+
+size_t CachingWeatherClient::Fetches() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fetches;
+}
+
+size_t CachingWeatherClient::Coalesced() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_coalesced;
+}
+
+void CachingWeatherClient::Insert(const Key& key, const DayWeather& day)
+{
+    if (m_entries.size() == m_capacity)
+    {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+    m_entries.push_front(Entry{key, day});
+    m_index.emplace(key, m_entries.begin());
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include "weather.h"
+#include <cstddef>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/*
+ * Weather of one date: the four times the server keeps, "<date>;03:00" to "<date>;21:00".
+*/
+struct DayWeather
+{
+    static const size_t s_timeCount = 4;
+    static const char* const s_times[s_timeCount];
+
+    Weather weather[s_timeCount];
+};
+
+// Fetches the four times of date, throws std::runtime_error when a response is invalid
+DayWeather FetchDayWeather(IWeatherServer& server, const std::string& date);
+
+double AverageTemperature(const DayWeather& day);
+double MinimumTemperature(const DayWeather& day);
+double MaximumTemperature(const DayWeather& day);
+double AverageWindDirection(const DayWeather& day);
+double MaximumWindSpeed(const DayWeather& day);
+
+/*
+ * Weather client which asks the server once per date.
+ *
+ * The four responses of a date are fetched together into DayWeather and kept in an LRU cache of
+ * capacity dates per server, so every statistic of a cached date is answered without a round trip.
+ * Concurrent requests for a date which is being fetched wait for that fetch instead of starting their own:
+ * the first request leaves a shared future in the in-flight map, later ones take it, and all of them get its
+ * result or its exception. Failed fetches are not cached.
+ *
+ * Thread-safe. The cache lock is not held during a fetch, so fetches of different dates run in parallel
+ * and the server must allow concurrent calls when the client is shared between threads.
+ * Dates are compared as strings.
+*/
+class CachingWeatherClient: public IWeatherClient
+{
+public:
+    // Throws std::invalid_argument for a zero capacity
+    explicit CachingWeatherClient(size_t capacity);
+
+    virtual double GetAverageTemperature(IWeatherServer& server, const std::string& date) override;
+    virtual double GetMinimumTemperature(IWeatherServer& server, const std::string& date) override;
+    virtual double GetMaximumTemperature(IWeatherServer& server, const std::string& date) override;
+    virtual double GetAverageWindDirection(IWeatherServer& server, const std::string& date) override;
+    virtual double GetMaximumWindSpeed(IWeatherServer& server, const std::string& date) override;
+
+    // Cached or fetched weather of date
+    DayWeather GetDayWeather(IWeatherServer& server, const std::string& date);
+
+    // Counters of answered requests: from the cache, by starting a fetch, by joining a fetch in flight
+    size_t Hits() const;
+    size_t Fetches() const;
+    size_t Coalesced() const;
+
+private:
+    typedef std::pair<IWeatherServer*, std::string> Key;
+
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        DayWeather day;
+    };
+
+    typedef std::list<Entry> Entries;
+
+    // Caller holds m_mutex
+    void Insert(const Key& key, const DayWeather& day);
+
+    size_t m_capacity;
+    mutable std::mutex m_mutex;
+    // Most recently used first
+    Entries m_entries;
+    std::unordered_map<Key, Entries::iterator, KeyHash> m_index;
+    std::unordered_map<Key, std::shared_future<DayWeather>, KeyHash> m_inFlight;
+    size_t m_hits;
+    size_t m_fetches;
+    size_t m_coalesced;
+};
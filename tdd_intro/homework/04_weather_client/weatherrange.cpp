@@ -0,0 +1,268 @@
+#include "weatherrange.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace
+{
+    const double s_pi = 3.14159265358979323846;
+    const double s_degreesPerRadian = 180 / s_pi;
+    // Length of the summed direction vectors, per response, below which the directions cancel out
+    const double s_cancelledLength = 1e-9;
+
+    struct Date
+    {
+        int day;
+        int month;
+        int year;
+    };
+
+    bool IsLeapYear(int year)
+    {
+        return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+    }
+
+    int DaysInMonth(int month, int year)
+    {
+        static const int s_days[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        return month == 2 && IsLeapYear(year) ? 29 : s_days[month - 1];
+    }
+
+    bool ReadNumber(const std::string& text, size_t begin, size_t size, int& value)
+    {
+        value = 0;
+        for (size_t i = begin; i < begin + size; ++i)
+        {
+            if (text[i] < '0' || text[i] > '9')
+            {
+                return false;
+            }
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    }
+
+    Date ParseDate(const std::string& text)
+    {
+        Date date;
+        if (text.size() != 10 || text[2] != '.' || text[5] != '.' || !ReadNumber(text, 0, 2, date.day) ||
+            !ReadNumber(text, 3, 2, date.month) || !ReadNumber(text, 6, 4, date.year) ||
+            date.month < 1 || date.month > 12 || date.day < 1 || date.day > DaysInMonth(date.month, date.year))
+        {
+            throw std::invalid_argument("Invalid date " + text);
+        }
+        return date;
+    }
+
+    std::string FormatDate(const Date& date)
+    {
+        char text[16];
+        std::snprintf(text, sizeof(text), "%02d.%02d.%04d", date.day, date.month, date.year);
+        return text;
+    }
+
+    bool Before(const Date& left, const Date& right)
+    {
+        if (left.year != right.year)
+        {
+            return left.year < right.year;
+        }
+        if (left.month != right.month)
+        {
+            return left.month < right.month;
+        }
+        return left.day < right.day;
+    }
+
+    Date NextDate(Date date)
+    {
+        if (++date.day > DaysInMonth(date.month, date.year))
+        {
+            date.day = 1;
+            if (++date.month > 12)
+            {
+                date.month = 1;
+                ++date.year;
+            }
+        }
+        return date;
+    }
+}
+
+WeatherAccumulator::WeatherAccumulator()
+    : m_count(0)
+    , m_mean(0)
+    , m_squares(0)
+    , m_minimum(0)
+    , m_maximum(0)
+    , m_sine(0)
+    , m_cosine(0)
+    , m_maximumSpeed(0)
+{
+}
+
+void WeatherAccumulator::Add(const Weather& weather)
+{
+    const double temperature = weather.temperature;
+    ++m_count;
+    const double delta = temperature - m_mean;
+    m_mean += delta / m_count;
+    m_squares += delta * (temperature - m_mean);
+    m_minimum = m_count == 1 ? temperature : std::min(m_minimum, temperature);
+    m_maximum = m_count == 1 ? temperature : std::max(m_maximum, temperature);
+    const double direction = weather.windDirection / s_degreesPerRadian;
+    m_sine += std::sin(direction);
+    m_cosine += std::cos(direction);
+    m_maximumSpeed = m_count == 1 ? weather.windSpeed : std::max(m_maximumSpeed, weather.windSpeed);
+}
+
+void WeatherAccumulator::Merge(const WeatherAccumulator& other)
+{
+    if (other.m_count == 0)
+    {
+        return;
+    }
+    if (m_count == 0)
+    {
+        *this = other;
+        return;
+    }
+    // Chan's update of the mean and the squared deviations of two parts
+    const double count = static_cast<double>(m_count + other.m_count);
+    const double delta = other.m_mean - m_mean;
+    m_mean += delta * other.m_count / count;
+    m_squares += other.m_squares + delta * delta * m_count * other.m_count / count;
+    m_count += other.m_count;
+    m_minimum = std::min(m_minimum, other.m_minimum);
+    m_maximum = std::max(m_maximum, other.m_maximum);
+    m_sine += other.m_sine;
+    m_cosine += other.m_cosine;
+    m_maximumSpeed = std::max(m_maximumSpeed, other.m_maximumSpeed);
+}
+
+WeatherStatistics WeatherAccumulator::Statistics() const
+{
+    WeatherStatistics statistics;
+    if (m_count == 0)
+    {
+        return statistics;
+    }
+    statistics.count = m_count;
+    statistics.minimumTemperature = m_minimum;
+    statistics.maximumTemperature = m_maximum;
+    statistics.averageTemperature = m_mean;
+    statistics.temperatureVariance = m_squares / m_count;
+    // Directions which cancel out leave only rounding errors, whose angle means nothing
+    if (std::hypot(m_sine, m_cosine) >= s_cancelledLength * m_count)
+    {
+        double direction = std::atan2(m_sine, m_cosine) * s_degreesPerRadian;
+        if (direction < 0)
+        {
+            direction += 360;
+        }
+        statistics.averageWindDirection = direction < 360 ? direction : 0;
+    }
+    statistics.maximumWindSpeed = m_maximumSpeed;
+    return statistics;
+}
+
+std::vector<std::string> DateRange(const std::string& first, const std::string& last)
+{
+    Date date = ParseDate(first);
+    const Date end = ParseDate(last);
+    if (Before(end, date))
+    {
+        throw std::invalid_argument("Date range ends before " + first);
+    }
+    std::vector<std::string> dates;
+    for (; Before(date, end); date = NextDate(date))
+    {
+        dates.push_back(FormatDate(date));
+    }
+    dates.push_back(FormatDate(end));
+    return dates;
+}
+
+RangeStatistics FetchRangeStatistics(IWeatherServer& server, const std::string& first, const std::string& last,
+                                     size_t parallelism)
+{
+    if (parallelism == 0)
+    {
+        throw std::invalid_argument("Parallelism must be positive");
+    }
+    const std::vector<std::string> dates = DateRange(first, last);
+    std::vector<DayWeather> days(dates.size());
+    std::atomic<size_t> nextDay(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr failure;
+    std::mutex failureMutex;
+
+    auto work = [&]
+    {
+        for (size_t day = nextDay++; day < dates.size() && !failed; day = nextDay++)
+        {
+            try
+            {
+                days[day] = FetchDayWeather(server, dates[day]);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure)
+                {
+                    failure = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    const size_t workerCount = std::min(parallelism, dates.size());
+    try
+    {
+        for (size_t worker = 1; worker < workerCount; ++worker)
+        {
+            workers.emplace_back(work);
+        }
+    }
+    catch (const std::system_error&)
+    {
+        // Fewer threads than asked for: the started ones and the calling one still fetch every date
+    }
+    work();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+
+    return AggregateRange(dates, days);
+}
+
+RangeStatistics AggregateRange(const std::vector<std::string>& dates, const std::vector<DayWeather>& days)
+{
+    RangeStatistics result;
+    result.days.reserve(dates.size());
+    WeatherAccumulator total;
+    for (size_t day = 0; day < dates.size(); ++day)
+    {
+        WeatherAccumulator accumulator;
+        for (const Weather& weather : days[day].weather)
+        {
+            accumulator.Add(weather);
+        }
+        total.Merge(accumulator);
+        result.days.push_back(DayStatistics{dates[day], accumulator.Statistics()});
+    }
+    result.total = total.Statistics();
+    return result;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "weather.h"
+#include "weatherclient.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*
+ * Weather statistics over a range of dates.
+ *
+ * FetchRangeStatistics asks the server for the four times of every date of the range. Worker threads take
+ * one date (a batch of four requests) at a time from a shared counter, so up to parallelism requests are
+ * in flight and no thread waits for a slow batch of another one.
+ * The responses are aggregated in one pass: WeatherAccumulator keeps a Welford running mean and variance
+ * of the temperature, a circular mean of the wind direction and the extremes, and accumulators of days
+ * merge into the one of the range. The statistics of every day come with the total, so nothing is fetched
+ * twice.
+ *
+ * The wind direction is averaged as an angle: 350 and 20 degrees average to 5, not to 185 as the
+ * arithmetic mean of IWeatherClient::GetAverageWindDirection gives.
+*/
+
+struct WeatherStatistics
+{
+    // Number of aggregated responses
+    size_t count = 0;
+    double minimumTemperature = 0;
+    double maximumTemperature = 0;
+    double averageTemperature = 0;
+    // Population variance
+    double temperatureVariance = 0;
+    // In [0, 360), 0 when the directions cancel out
+    double averageWindDirection = 0;
+    double maximumWindSpeed = 0;
+};
+
+class WeatherAccumulator
+{
+public:
+    WeatherAccumulator();
+
+    void Add(const Weather& weather);
+    // Same result as adding every response of other
+    void Merge(const WeatherAccumulator& other);
+    // Zero statistics when nothing was added
+    WeatherStatistics Statistics() const;
+
+private:
+    size_t m_count;
+    double m_mean;
+    // Sum of squared deviations from the mean
+    double m_squares;
+    double m_minimum;
+    double m_maximum;
+    // Sums of the unit vectors of the wind directions
+    double m_sine;
+    double m_cosine;
+    double m_maximumSpeed;
+};
+
+struct DayStatistics
+{
+    std::string date;
+    WeatherStatistics statistics;
+};
+
+struct RangeStatistics
+{
+    WeatherStatistics total;
+    // In date order
+    std::vector<DayStatistics> days;
+};
+
+// Dates "dd.mm.yyyy" from first to last inclusively, throws std::invalid_argument when a date is invalid
+// or last is before first
+std::vector<std::string> DateRange(const std::string& first, const std::string& last);
+
+// Throws std::invalid_argument for an invalid range or a zero parallelism and std::runtime_error when a
+// response is invalid. The server must allow concurrent calls when parallelism is above one.
+RangeStatistics FetchRangeStatistics(IWeatherServer& server, const std::string& first, const std::string& last,
+                                     size_t parallelism);
+
+// Statistics of days[i] fetched for dates[i], per day and in total
+RangeStatistics AggregateRange(const std::vector<std::string>& dates, const std::vector<DayWeather>& days);
@@ -4,6 +4,17 @@ TEMPLATE = app
 CONFIG += console c++11
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 SOURCES += \
-    test.cpp
+    test.cpp \
+    wordwrap.cpp \
+    displaywidth.cpp \
+    threadpool.cpp \
+    allocationcounter.cpp
+
+HEADERS += \
+    wordwrap.h \
+    displaywidth.h \
+    threadpool.h \
+    allocationcounter.h
@@ -0,0 +1,5 @@
+#pragma once
+#include <cstddef>
+
+// Number of global operator new calls made by the test program so far
+size_t AllocationCount();
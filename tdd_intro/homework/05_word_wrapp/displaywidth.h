@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Terminal display width of UTF-8 text.
+ *
+ * Code point widths come from a two-level table of constant data: the high bits of a code point select one of
+ * the distinct 256 code point blocks, which stores 2 bits per code point. Identical blocks are shared, so the
+ * whole Unicode range takes about 10 KB and nothing is built at run time. East Asian Wide and Fullwidth characters (and emoji) take 2 columns,
+ * combining marks, joiners and variation selectors take none, everything else takes 1.
+ *
+ * Grapheme clusters are approximated by a base character with the following zero width code points,
+ * characters joined by ZERO WIDTH JOINER and pairs of regional indicators (flags).
+ * Malformed UTF-8 bytes are taken one by one as 1 column wide characters.
+*/
+
+unsigned CodePointWidth(uint32_t codePoint);
+
+// Decodes a code point at pos, returns its length in bytes (at least 1)
+size_t DecodeUtf8(const char* str, size_t size, size_t pos, uint32_t& codePoint);
+
+// Returns the end of the grapheme cluster starting at pos and sets width to its display width
+size_t NextGraphemeCluster(const char* str, size_t size, size_t pos, unsigned& width);
+
+// Returns true if all bytes in [str, str + size) are ASCII
+bool IsAscii(const char* str, size_t size);
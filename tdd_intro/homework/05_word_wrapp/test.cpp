@@ -16,7 +16,20 @@ ignoring any possible match beginning after pos
 */
 
 #include <gtest/gtest.h>
-#include <cctype>
+#include "wordwrap.h"
+#include "allocationcounter.h"
+#include "displaywidth.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
 
 // empty string
 // string shorter than wrap number
@@ -28,33 +41,6 @@ ignoring any possible match beginning after pos
 // string wrapped by several whitespaces (more than wrapLength)
 // only whitespaces in string
 
-using WrappedStrings = std::vector<std::string>;
-
-WrappedStrings WrapString(const std::string& str, size_t wrapLength)
-{
-    WrappedStrings result;
-    for(size_t i = 0; i < str.length(); i += wrapLength)
-    {
-        std::string cur = str.substr(i, wrapLength);
-        if (cur.back() == ' ')
-        {
-            cur.pop_back();
-        }
-
-        if(!cur.empty() && cur.front() == ' ')
-        {
-            cur = cur.substr(1);
-        }
-
-        if(!cur.empty())
-        {
-            result.push_back(cur);
-        }
-    }
-
-    return result;
-}
-
 TEST(WrapString, EmptyString)
 {
     ASSERT_EQ(WrappedStrings(), WrapString("", 25));
@@ -94,3 +80,785 @@ TEST(WrapString, StringWrappedBySeveralWhitespace)
     WrappedStrings expected = {"12", "34"};
     ASSERT_EQ(expected, WrapString("12  34", 3));
 }
+
+TEST(WrapString, BreaksAtLastSpace)
+{
+    WrappedStrings expected = {"12 34", "56"};
+    ASSERT_EQ(expected, WrapString("12 34 56", 6));
+}
+
+TEST(WrapString, KeepsSpacesInsideLine)
+{
+    WrappedStrings expected = {"12  34", "56"};
+    ASSERT_EQ(expected, WrapString("  12  34   56  ", 7));
+}
+
+TEST(WrapString, OnlyWhitespaces)
+{
+    ASSERT_EQ(WrappedStrings(), WrapString("     ", 2));
+}
+
+TEST(WrapString, LongWordAmongShortOnes)
+{
+    WrappedStrings expected = {"a", "bcd", "ef", "g"};
+    ASSERT_EQ(expected, WrapString("a bcdef g", 3));
+}
+
+static const std::string s_specText = "When pos is specified, the search only includes sequences of characters that begin at or "
+                                      "before position pos, ignoring any possible match beginning after pos.";
+
+TEST(WrapString, Acceptance)
+{
+    WrappedStrings expected = {
+        "When pos is specified, the",
+        "search only includes sequences",
+        "of characters that begin at or",
+        "before position pos, ignoring",
+        "any possible match beginning",
+        "after pos."
+    };
+    ASSERT_EQ(expected, WrapString(s_specText, 30));
+}
+
+TEST(WrapStringMinimumRaggedness, EmptyString)
+{
+    ASSERT_EQ(WrappedStrings(), WrapString("  ", 5, WrapMode::MinimumRaggedness));
+}
+
+TEST(WrapStringMinimumRaggedness, BalancesLines)
+{
+    // Greedy gives "aaa bb", "cc", "ddddd" with cost 0 + 16
+    WrappedStrings expected = {"aaa", "bb cc", "ddddd"};
+    ASSERT_EQ(expected, WrapString("aaa bb cc ddddd", 6, WrapMode::MinimumRaggedness));
+}
+
+TEST(WrapStringMinimumRaggedness, LastLineIsFree)
+{
+    WrappedStrings expected = {"aaaa bb", "c"};
+    ASSERT_EQ(expected, WrapString("aaaa bb c", 7, WrapMode::MinimumRaggedness));
+}
+
+TEST(WrapStringMinimumRaggedness, LongWord)
+{
+    WrappedStrings expected = {"123", "456", "7 8"};
+    ASSERT_EQ(expected, WrapString("1234567 8", 3, WrapMode::MinimumRaggedness));
+}
+
+uint64_t Raggedness(const WrappedStrings& lines, size_t wrapLength)
+{
+    uint64_t cost = 0;
+    for (size_t i = 0; i + 1 < lines.size(); ++i)
+    {
+        EXPECT_LE(lines[i].size(), wrapLength);
+        cost += (wrapLength - lines[i].size()) * (wrapLength - lines[i].size());
+    }
+    return cost;
+}
+
+// Quadratic dynamic programming over words separated by single spaces
+uint64_t MinimumRaggednessNaive(const std::vector<size_t>& wordLengths, size_t wrapLength)
+{
+    const size_t count = wordLengths.size();
+    std::vector<uint64_t> best(count + 1, std::numeric_limits<uint64_t>::max());
+    best[0] = 0;
+    uint64_t result = std::numeric_limits<uint64_t>::max();
+    for (size_t first = 0; first < count; ++first)
+    {
+        size_t length = wordLengths[first];
+        for (size_t end = first + 1; end <= count && length <= wrapLength; ++end)
+        {
+            if (end == count)
+            {
+                result = std::min(result, best[first]);
+            }
+            else
+            {
+                best[end] = std::min(best[end], best[first] + (wrapLength - length) * (wrapLength - length));
+                length += 1 + wordLengths[end];
+            }
+        }
+    }
+    return result;
+}
+
+TEST(WrapStringMinimumRaggedness, MatchesQuadraticSolution)
+{
+    uint32_t seed = 12345;
+    for (size_t wrapLength : {5u, 10u, 17u, 40u})
+    {
+        for (int sample = 0; sample < 50; ++sample)
+        {
+            std::string text;
+            std::vector<size_t> wordLengths;
+            for (int word = 0; word < 60; ++word)
+            {
+                seed = seed * 1664525u + 1013904223u;
+                wordLengths.push_back(1 + (seed >> 16) % wrapLength);
+                text += (text.empty() ? "" : " ") + std::string(wordLengths.back(), 'x');
+            }
+            const WrappedStrings lines = WrapString(text, wrapLength, WrapMode::MinimumRaggedness);
+            ASSERT_EQ(MinimumRaggednessNaive(wordLengths, wrapLength), Raggedness(lines, wrapLength)) << text;
+        }
+    }
+}
+
+TEST(WrapStringMinimumRaggedness, NotWorseThanGreedy)
+{
+    const WrappedStrings greedy = WrapString(s_specText, 30);
+    const WrappedStrings balanced = WrapString(s_specText, 30, WrapMode::MinimumRaggedness);
+    ASSERT_LE(Raggedness(balanced, 30), Raggedness(greedy, 30));
+}
+
+TEST(WrapSpans, PointIntoOriginalText)
+{
+    LineSpans lines;
+    WrapSpans("  12  34   56  ", 7, lines);
+    LineSpans expected = {{2, 6}, {11, 2}};
+    ASSERT_EQ(expected, lines);
+}
+
+TEST(WrapSpans, SameLinesAsWrapString)
+{
+    for (WrapMode mode : {WrapMode::Greedy, WrapMode::MinimumRaggedness})
+    {
+        LineSpans lines;
+        WrapSpans(s_specText, 30, lines, mode);
+        const WrappedStrings strings = WrapString(s_specText, 30, mode);
+        ASSERT_EQ(strings.size(), lines.size());
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            ASSERT_EQ(strings[i], s_specText.substr(lines[i].offset, lines[i].length));
+        }
+    }
+}
+
+TEST(WrapSpans, Buffer)
+{
+    LineSpan lines[6];
+    ASSERT_EQ(6u, WrapSpans(s_specText.data(), s_specText.size(), 30, lines, 6));
+    ASSERT_EQ((LineSpan{0, 26}), lines[0]);
+    ASSERT_EQ("after pos.", s_specText.substr(lines[5].offset, lines[5].length));
+}
+
+TEST(WrapSpans, BufferTooSmall)
+{
+    LineSpan lines[2] = {{1, 1}, {1, 1}};
+    ASSERT_EQ(6u, WrapSpans(s_specText.data(), s_specText.size(), 30, lines, 1));
+    ASSERT_EQ((LineSpan{0, 26}), lines[0]);
+    ASSERT_EQ((LineSpan{1, 1}), lines[1]);
+}
+
+TEST(WrapSpans, NoAllocationWithReusedVector)
+{
+    LineSpans lines;
+    WrapSpans(s_specText, 12, lines);
+    const size_t before = AllocationCount();
+    WrapSpans(s_specText, 30, lines);
+    WrapSpans(s_specText, 12, lines);
+    WrapSpans(s_specText, 30, lines);
+    ASSERT_EQ(before, AllocationCount());
+}
+
+TEST(WrapSpans, NoAllocationWithBuffer)
+{
+    LineSpan lines[16];
+    const size_t before = AllocationCount();
+    WrapSpans(s_specText.data(), s_specText.size(), 12, lines, 16);
+    ASSERT_EQ(before, AllocationCount());
+}
+
+TEST(WrapSpansBenchmark, DISABLED_AllocationsAndTime)
+{
+    std::string text;
+    uint32_t seed = 12345;
+    while (text.size() < (16 << 20))
+    {
+        seed = seed * 1664525u + 1013904223u;
+        text += std::string(1 + (seed >> 16) % 12, 'x') + ' ';
+    }
+
+    size_t allocations = AllocationCount();
+    auto start = std::chrono::steady_clock::now();
+    const WrappedStrings strings = WrapString(text, 72);
+    const auto stringsTime = std::chrono::steady_clock::now() - start;
+    const size_t stringsAllocations = AllocationCount() - allocations;
+
+    LineSpans lines;
+    lines.reserve(strings.size());
+    allocations = AllocationCount();
+    start = std::chrono::steady_clock::now();
+    WrapSpans(text, 72, lines);
+    const auto spansTime = std::chrono::steady_clock::now() - start;
+    const size_t spansAllocations = AllocationCount() - allocations;
+
+    ASSERT_EQ(strings.size(), lines.size());
+    std::cout << lines.size() << " lines\n"
+              << "WrapString: " << stringsAllocations << " allocations, "
+              << std::chrono::duration<double, std::milli>(stringsTime).count() << " ms\n"
+              << "WrapSpans: " << spansAllocations << " allocations, "
+              << std::chrono::duration<double, std::milli>(spansTime).count() << " ms" << std::endl;
+    EXPECT_EQ(0u, spansAllocations);
+}
+
+WrappedStrings WrapStreaming(const std::string& str, size_t wrapLength, size_t chunkSize)
+{
+    WrappedStrings lines;
+    StreamingWrapper wrapper(wrapLength, [&lines](const char* line, size_t length)
+    {
+        lines.emplace_back(line, length);
+    });
+    for (size_t pos = 0; pos < str.size(); pos += chunkSize)
+    {
+        wrapper.Write(str.substr(pos, chunkSize));
+    }
+    wrapper.Finish();
+    return lines;
+}
+
+TEST(StreamingWrapper, Empty)
+{
+    ASSERT_EQ(WrappedStrings(), WrapStreaming("", 10, 1));
+    ASSERT_EQ(WrappedStrings(), WrapStreaming("    ", 2, 3));
+}
+
+TEST(StreamingWrapper, SingleChunk)
+{
+    ASSERT_EQ(WrapString(s_specText, 30), WrapStreaming(s_specText, 30, s_specText.size()));
+}
+
+TEST(StreamingWrapper, CharacterByCharacter)
+{
+    ASSERT_EQ(WrapString(s_specText, 30), WrapStreaming(s_specText, 30, 1));
+}
+
+TEST(StreamingWrapper, LineSplitBetweenChunks)
+{
+    WrappedStrings expected = {"12 34", "56"};
+    ASSERT_EQ(expected, WrapStreaming("12 34 56", 6, 4));
+}
+
+TEST(StreamingWrapper, LongWordAcrossChunks)
+{
+    WrappedStrings expected = {"a", "bcd", "efg", "hi", "j"};
+    ASSERT_EQ(expected, WrapStreaming("a   bcdefghi   j", 3, 2));
+}
+
+TEST(StreamingWrapper, MatchesBatchForAnyChunking)
+{
+    uint32_t seed = 12345;
+    for (int sample = 0; sample < 200; ++sample)
+    {
+        std::string text;
+        for (int word = 0; word < 40; ++word)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            text += std::string(1 + (seed >> 16) % 3, ' ') + std::string(1 + (seed >> 20) % 15, 'x');
+        }
+        for (size_t wrapLength : {1u, 4u, 9u, 20u})
+        {
+            for (size_t chunkSize : {1u, 3u, 8u, 64u})
+            {
+                ASSERT_EQ(WrapString(text, wrapLength), WrapStreaming(text, wrapLength, chunkSize))
+                    << "\"" << text << "\" " << wrapLength << " " << chunkSize;
+            }
+        }
+    }
+}
+
+TEST(StreamingWrapperBenchmark, DISABLED_MultiGigabyteInput)
+{
+    // A pattern of random words fed repeatedly, as if read from a pipe
+    std::string chunk;
+    uint32_t seed = 12345;
+    while (chunk.size() < (64 << 10))
+    {
+        seed = seed * 1664525u + 1013904223u;
+        chunk += std::string(1 + (seed >> 16) % 12, 'x') + std::string(1 + (seed >> 24) % 2, ' ');
+    }
+    const size_t totalSize = size_t(4) << 30;
+
+    size_t lines = 0;
+    size_t characters = 0;
+    StreamingWrapper wrapper(80, [&](const char*, size_t length)
+    {
+        ++lines;
+        characters += length;
+    });
+    const size_t allocations = AllocationCount();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t written = 0; written < totalSize; written += chunk.size())
+    {
+        wrapper.Write(chunk);
+    }
+    wrapper.Finish();
+    const auto time = std::chrono::steady_clock::now() - start;
+
+    std::cout << lines << " lines, " << characters << " characters, "
+              << totalSize / std::chrono::duration<double, std::micro>(time).count() << " MB/s, "
+              << AllocationCount() - allocations << " allocations, "
+              << "carried line buffer: 81 bytes" << std::endl;
+    EXPECT_EQ(0u, AllocationCount() - allocations);
+}
+
+TEST(WrapStringDisplayWidth, AsciiAsGreedy)
+{
+    ASSERT_EQ(WrapString(s_specText, 30), WrapString(s_specText, 30, WrapMode::DisplayWidth));
+    ASSERT_EQ(WrapString("a bcdef g", 3), WrapString("a bcdef g", 3, WrapMode::DisplayWidth));
+    ASSERT_EQ(WrapString("12  34", 3), WrapString("12  34", 3, WrapMode::DisplayWidth));
+}
+
+TEST(WrapStringDisplayWidth, LatinCountsCharacters)
+{
+    // Every accented letter takes two bytes, but a single column
+    WrappedStrings expected = {"caf\xC3\xA9 na\xC3\xAFve", "r\xC3\xA9sum\xC3\xA9"};
+    ASSERT_EQ(expected, WrapString("caf\xC3\xA9 na\xC3\xAFve r\xC3\xA9sum\xC3\xA9", 10, WrapMode::DisplayWidth));
+}
+
+TEST(WrapStringDisplayWidth, CombiningMarks)
+{
+    // e + COMBINING ACUTE ACCENT is a single column
+    const std::string word = "e\xCC\x81" "e\xCC\x81" "e\xCC\x81";
+    WrappedStrings expected = {word, word};
+    ASSERT_EQ(expected, WrapString(word + " " + word, 3, WrapMode::DisplayWidth));
+}
+
+TEST(WrapStringDisplayWidth, WideCharacters)
+{
+    // Four CJK ideographs take eight columns
+    const std::string kanji = "\xE6\xBC\xA2\xE5\xAD\x97\xE6\xBC\xA2\xE5\xAD\x97";
+    WrappedStrings expected = {"\xE6\xBC\xA2\xE5\xAD\x97", "\xE6\xBC\xA2\xE5\xAD\x97", "ab"};
+    ASSERT_EQ(expected, WrapString(kanji + " ab", 5, WrapMode::DisplayWidth));
+}
+
+TEST(WrapStringDisplayWidth, WideCharacterWiderThanLine)
+{
+    WrappedStrings expected = {"\xE6\xBC\xA2", "\xE5\xAD\x97"};
+    ASSERT_EQ(expected, WrapString("\xE6\xBC\xA2\xE5\xAD\x97", 1, WrapMode::DisplayWidth));
+}
+
+TEST(WrapStringDisplayWidth, EmojiSequences)
+{
+    // Flag of Ukraine (two regional indicators) and a family joined by ZERO WIDTH JOINER take two columns each
+    const std::string flag = "\xF0\x9F\x87\xBA\xF0\x9F\x87\xA6";
+    const std::string family = "\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9\xE2\x80\x8D\xF0\x9F\x91\xA7";
+    WrappedStrings expected = {flag + family, "x"};
+    ASSERT_EQ(expected, WrapString(flag + family + " x", 4, WrapMode::DisplayWidth));
+}
+
+TEST(WrapStringDisplayWidth, MalformedBytes)
+{
+    WrappedStrings expected = {"\xFF\xFE", "\xC3"};
+    ASSERT_EQ(expected, WrapString("\xFF\xFE\xC3", 2, WrapMode::DisplayWidth));
+}
+
+TEST(DisplayWidth, CodePoints)
+{
+    ASSERT_EQ(1u, CodePointWidth('a'));
+    ASSERT_EQ(1u, CodePointWidth(0xE9));
+    ASSERT_EQ(0u, CodePointWidth(0x301));
+    ASSERT_EQ(2u, CodePointWidth(0x6F22));
+    ASSERT_EQ(2u, CodePointWidth(0xAC00));
+    ASSERT_EQ(2u, CodePointWidth(0xFF21));
+    ASSERT_EQ(2u, CodePointWidth(0x1F600));
+    ASSERT_EQ(0u, CodePointWidth(0x1F3FB));
+    ASSERT_EQ(1u, CodePointWidth(0x10FFFF));
+}
+
+TEST(DisplayWidth, IndicMarks)
+{
+    for (uint32_t mark : {0x09C1, 0x0A41, 0x0BCD, 0x0C3E, 0x0D41, 0x0EB4, 0x0F72, 0x102D, 0x17B7, 0xA8E0})
+    {
+        ASSERT_EQ(0u, CodePointWidth(mark)) << std::hex << mark;
+    }
+}
+
+TEST(WrapStringDisplayWidth, IndicMarks)
+{
+    // "kuchh" in Bengali, Telugu "ti" and Devanagari KA with COMBINING DEVANAGARI DIGIT ZERO (U+A8E0)
+    const std::string bengali = "\xE0\xA6\x95\xE0\xA7\x81\xE0\xA6\x9B";
+    const std::string telugu = "\xE0\xB0\x9F\xE0\xB0\xBF";
+    const std::string devanagari = "\xE0\xA4\x95\xEA\xA3\xA0";
+    WrappedStrings expected = {bengali + " " + telugu, devanagari};
+    ASSERT_EQ(expected, WrapString(bengali + " " + telugu + " " + devanagari, 4, WrapMode::DisplayWidth));
+}
+
+struct WidthRange
+{
+    uint32_t first;
+    uint32_t last;
+};
+
+// Ranges the width table of displaywidth.cpp is generated from, taken from the Unicode 14.0 character database.
+// Wide: East_Asian_Width W and F, the CJK ranges which default to W and unassigned code points between wide ones.
+const WidthRange s_wideRanges[] = {
+    {0x1100, 0x115F}, {0x231A, 0x231B}, {0x2329, 0x232A}, {0x23E9, 0x23EC}, {0x23F0, 0x23F0}, {0x23F3, 0x23F3},
+    {0x25FD, 0x25FE}, {0x2614, 0x2615}, {0x2648, 0x2653}, {0x267F, 0x267F}, {0x2693, 0x2693}, {0x26A1, 0x26A1},
+    {0x26AA, 0x26AB}, {0x26BD, 0x26BE}, {0x26C4, 0x26C5}, {0x26CE, 0x26CE}, {0x26D4, 0x26D4}, {0x26EA, 0x26EA},
+    {0x26F2, 0x26F3}, {0x26F5, 0x26F5}, {0x26FA, 0x26FA}, {0x26FD, 0x26FD}, {0x2705, 0x2705}, {0x270A, 0x270B},
+    {0x2728, 0x2728}, {0x274C, 0x274C}, {0x274E, 0x274E}, {0x2753, 0x2755}, {0x2757, 0x2757}, {0x2795, 0x2797},
+    {0x27B0, 0x27B0}, {0x27BF, 0x27BF}, {0x2B1B, 0x2B1C}, {0x2B50, 0x2B50}, {0x2B55, 0x2B55}, {0x2E80, 0x303E},
+    {0x3041, 0x3247}, {0x3250, 0x4DBF}, {0x4E00, 0xA4C6}, {0xA960, 0xA97C}, {0xAC00, 0xD7A3}, {0xF900, 0xFAFF},
+    {0xFE10, 0xFE19}, {0xFE30, 0xFE6B}, {0xFF01, 0xFF60}, {0xFFE0, 0xFFE6}, {0x16FE0, 0x1B2FB}, {0x1F004, 0x1F004},
+    {0x1F0CF, 0x1F0CF}, {0x1F18E, 0x1F18E}, {0x1F191, 0x1F19A}, {0x1F200, 0x1F320}, {0x1F32D, 0x1F335},
+    {0x1F337, 0x1F37C}, {0x1F37E, 0x1F393}, {0x1F3A0, 0x1F3CA}, {0x1F3CF, 0x1F3D3}, {0x1F3E0, 0x1F3F0},
+    {0x1F3F4, 0x1F3F4}, {0x1F3F8, 0x1F43E}, {0x1F440, 0x1F440}, {0x1F442, 0x1F4FC}, {0x1F4FF, 0x1F53D},
+    {0x1F54B, 0x1F54E}, {0x1F550, 0x1F567}, {0x1F57A, 0x1F57A}, {0x1F595, 0x1F596}, {0x1F5A4, 0x1F5A4},
+    {0x1F5FB, 0x1F64F}, {0x1F680, 0x1F6C5}, {0x1F6CC, 0x1F6CC}, {0x1F6D0, 0x1F6D2}, {0x1F6D5, 0x1F6DF},
+    {0x1F6EB, 0x1F6EC}, {0x1F6F4, 0x1F6FC}, {0x1F7E0, 0x1F7F0}, {0x1F90C, 0x1F93A}, {0x1F93C, 0x1F945},
+    {0x1F947, 0x1F9FF}, {0x1FA70, 0x1FAF6}, {0x20000, 0x3FFFD}
+};
+
+// Applied after the wide ranges. General_Category Mn, Me and Cf except SOFT HYPHEN and the prepended
+// concatenation marks, which terminals show, plus Hangul medial and final jamo and emoji skin tone modifiers.
+const WidthRange s_zeroWidthRanges[] = {
+    {0x0300, 0x036F}, {0x0483, 0x0489}, {0x0591, 0x05BD}, {0x05BF, 0x05BF}, {0x05C1, 0x05C2}, {0x05C4, 0x05C5},
+    {0x05C7, 0x05C7}, {0x0610, 0x061A}, {0x061C, 0x061C}, {0x064B, 0x065F}, {0x0670, 0x0670}, {0x06D6, 0x06DC},
+    {0x06DF, 0x06E4}, {0x06E7, 0x06E8}, {0x06EA, 0x06ED}, {0x0711, 0x0711}, {0x0730, 0x074A}, {0x07A6, 0x07B0},
+    {0x07EB, 0x07F3}, {0x07FD, 0x07FD}, {0x0816, 0x0819}, {0x081B, 0x0823}, {0x0825, 0x0827}, {0x0829, 0x082D},
+    {0x0859, 0x085B}, {0x0898, 0x089F}, {0x08CA, 0x08E1}, {0x08E3, 0x0902}, {0x093A, 0x093A}, {0x093C, 0x093C},
+    {0x0941, 0x0948}, {0x094D, 0x094D}, {0x0951, 0x0957}, {0x0962, 0x0963}, {0x0981, 0x0981}, {0x09BC, 0x09BC},
+    {0x09C1, 0x09C4}, {0x09CD, 0x09CD}, {0x09E2, 0x09E3}, {0x09FE, 0x09FE}, {0x0A01, 0x0A02}, {0x0A3C, 0x0A3C},
+    {0x0A41, 0x0A42}, {0x0A47, 0x0A48}, {0x0A4B, 0x0A4D}, {0x0A51, 0x0A51}, {0x0A70, 0x0A71}, {0x0A75, 0x0A75},
+    {0x0A81, 0x0A82}, {0x0ABC, 0x0ABC}, {0x0AC1, 0x0AC5}, {0x0AC7, 0x0AC8}, {0x0ACD, 0x0ACD}, {0x0AE2, 0x0AE3},
+    {0x0AFA, 0x0AFF}, {0x0B01, 0x0B01}, {0x0B3C, 0x0B3C}, {0x0B3F, 0x0B3F}, {0x0B41, 0x0B44}, {0x0B4D, 0x0B4D},
+    {0x0B55, 0x0B56}, {0x0B62, 0x0B63}, {0x0B82, 0x0B82}, {0x0BC0, 0x0BC0}, {0x0BCD, 0x0BCD}, {0x0C00, 0x0C00},
+    {0x0C04, 0x0C04}, {0x0C3C, 0x0C3C}, {0x0C3E, 0x0C40}, {0x0C46, 0x0C48}, {0x0C4A, 0x0C4D}, {0x0C55, 0x0C56},
+    {0x0C62, 0x0C63}, {0x0C81, 0x0C81}, {0x0CBC, 0x0CBC}, {0x0CBF, 0x0CBF}, {0x0CC6, 0x0CC6}, {0x0CCC, 0x0CCD},
+    {0x0CE2, 0x0CE3}, {0x0D00, 0x0D01}, {0x0D3B, 0x0D3C}, {0x0D41, 0x0D44}, {0x0D4D, 0x0D4D}, {0x0D62, 0x0D63},
+    {0x0D81, 0x0D81}, {0x0DCA, 0x0DCA}, {0x0DD2, 0x0DD4}, {0x0DD6, 0x0DD6}, {0x0E31, 0x0E31}, {0x0E34, 0x0E3A},
+    {0x0E47, 0x0E4E}, {0x0EB1, 0x0EB1}, {0x0EB4, 0x0EBC}, {0x0EC8, 0x0ECD}, {0x0F18, 0x0F19}, {0x0F35, 0x0F35},
+    {0x0F37, 0x0F37}, {0x0F39, 0x0F39}, {0x0F71, 0x0F7E}, {0x0F80, 0x0F84}, {0x0F86, 0x0F87}, {0x0F8D, 0x0F97},
+    {0x0F99, 0x0FBC}, {0x0FC6, 0x0FC6}, {0x102D, 0x1030}, {0x1032, 0x1037}, {0x1039, 0x103A}, {0x103D, 0x103E},
+    {0x1058, 0x1059}, {0x105E, 0x1060}, {0x1071, 0x1074}, {0x1082, 0x1082}, {0x1085, 0x1086}, {0x108D, 0x108D},
+    {0x109D, 0x109D}, {0x1160, 0x11FF}, {0x135D, 0x135F}, {0x1712, 0x1714}, {0x1732, 0x1733}, {0x1752, 0x1753},
+    {0x1772, 0x1773}, {0x17B4, 0x17B5}, {0x17B7, 0x17BD}, {0x17C6, 0x17C6}, {0x17C9, 0x17D3}, {0x17DD, 0x17DD},
+    {0x180B, 0x180F}, {0x1885, 0x1886}, {0x18A9, 0x18A9}, {0x1920, 0x1922}, {0x1927, 0x1928}, {0x1932, 0x1932},
+    {0x1939, 0x193B}, {0x1A17, 0x1A18}, {0x1A1B, 0x1A1B}, {0x1A56, 0x1A56}, {0x1A58, 0x1A5E}, {0x1A60, 0x1A60},
+    {0x1A62, 0x1A62}, {0x1A65, 0x1A6C}, {0x1A73, 0x1A7C}, {0x1A7F, 0x1A7F}, {0x1AB0, 0x1ACE}, {0x1B00, 0x1B03},
+    {0x1B34, 0x1B34}, {0x1B36, 0x1B3A}, {0x1B3C, 0x1B3C}, {0x1B42, 0x1B42}, {0x1B6B, 0x1B73}, {0x1B80, 0x1B81},
+    {0x1BA2, 0x1BA5}, {0x1BA8, 0x1BA9}, {0x1BAB, 0x1BAD}, {0x1BE6, 0x1BE6}, {0x1BE8, 0x1BE9}, {0x1BED, 0x1BED},
+    {0x1BEF, 0x1BF1}, {0x1C2C, 0x1C33}, {0x1C36, 0x1C37}, {0x1CD0, 0x1CD2}, {0x1CD4, 0x1CE0}, {0x1CE2, 0x1CE8},
+    {0x1CED, 0x1CED}, {0x1CF4, 0x1CF4}, {0x1CF8, 0x1CF9}, {0x1DC0, 0x1DFF}, {0x200B, 0x200F}, {0x202A, 0x202E},
+    {0x2060, 0x2064}, {0x2066, 0x206F}, {0x20D0, 0x20F0}, {0x2CEF, 0x2CF1}, {0x2D7F, 0x2D7F}, {0x2DE0, 0x2DFF},
+    {0x302A, 0x302D}, {0x3099, 0x309A}, {0xA66F, 0xA672}, {0xA674, 0xA67D}, {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1},
+    {0xA802, 0xA802}, {0xA806, 0xA806}, {0xA80B, 0xA80B}, {0xA825, 0xA826}, {0xA82C, 0xA82C}, {0xA8C4, 0xA8C5},
+    {0xA8E0, 0xA8F1}, {0xA8FF, 0xA8FF}, {0xA926, 0xA92D}, {0xA947, 0xA951}, {0xA980, 0xA982}, {0xA9B3, 0xA9B3},
+    {0xA9B6, 0xA9B9}, {0xA9BC, 0xA9BD}, {0xA9E5, 0xA9E5}, {0xAA29, 0xAA2E}, {0xAA31, 0xAA32}, {0xAA35, 0xAA36},
+    {0xAA43, 0xAA43}, {0xAA4C, 0xAA4C}, {0xAA7C, 0xAA7C}, {0xAAB0, 0xAAB0}, {0xAAB2, 0xAAB4}, {0xAAB7, 0xAAB8},
+    {0xAABE, 0xAABF}, {0xAAC1, 0xAAC1}, {0xAAEC, 0xAAED}, {0xAAF6, 0xAAF6}, {0xABE5, 0xABE5}, {0xABE8, 0xABE8},
+    {0xABED, 0xABED}, {0xD7B0, 0xD7FF}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFEFF, 0xFEFF},
+    {0xFFF9, 0xFFFB}, {0x101FD, 0x101FD}, {0x102E0, 0x102E0}, {0x10376, 0x1037A}, {0x10A01, 0x10A03},
+    {0x10A05, 0x10A06}, {0x10A0C, 0x10A0F}, {0x10A38, 0x10A3A}, {0x10A3F, 0x10A3F}, {0x10AE5, 0x10AE6},
+    {0x10D24, 0x10D27}, {0x10EAB, 0x10EAC}, {0x10F46, 0x10F50}, {0x10F82, 0x10F85}, {0x11001, 0x11001},
+    {0x11038, 0x11046}, {0x11070, 0x11070}, {0x11073, 0x11074}, {0x1107F, 0x11081}, {0x110B3, 0x110B6},
+    {0x110B9, 0x110BA}, {0x110C2, 0x110C2}, {0x11100, 0x11102}, {0x11127, 0x1112B}, {0x1112D, 0x11134},
+    {0x11173, 0x11173}, {0x11180, 0x11181}, {0x111B6, 0x111BE}, {0x111C9, 0x111CC}, {0x111CF, 0x111CF},
+    {0x1122F, 0x11231}, {0x11234, 0x11234}, {0x11236, 0x11237}, {0x1123E, 0x1123E}, {0x112DF, 0x112DF},
+    {0x112E3, 0x112EA}, {0x11300, 0x11301}, {0x1133B, 0x1133C}, {0x11340, 0x11340}, {0x11366, 0x1136C},
+    {0x11370, 0x11374}, {0x11438, 0x1143F}, {0x11442, 0x11444}, {0x11446, 0x11446}, {0x1145E, 0x1145E},
+    {0x114B3, 0x114B8}, {0x114BA, 0x114BA}, {0x114BF, 0x114C0}, {0x114C2, 0x114C3}, {0x115B2, 0x115B5},
+    {0x115BC, 0x115BD}, {0x115BF, 0x115C0}, {0x115DC, 0x115DD}, {0x11633, 0x1163A}, {0x1163D, 0x1163D},
+    {0x1163F, 0x11640}, {0x116AB, 0x116AB}, {0x116AD, 0x116AD}, {0x116B0, 0x116B5}, {0x116B7, 0x116B7},
+    {0x1171D, 0x1171F}, {0x11722, 0x11725}, {0x11727, 0x1172B}, {0x1182F, 0x11837}, {0x11839, 0x1183A},
+    {0x1193B, 0x1193C}, {0x1193E, 0x1193E}, {0x11943, 0x11943}, {0x119D4, 0x119D7}, {0x119DA, 0x119DB},
+    {0x119E0, 0x119E0}, {0x11A01, 0x11A0A}, {0x11A33, 0x11A38}, {0x11A3B, 0x11A3E}, {0x11A47, 0x11A47},
+    {0x11A51, 0x11A56}, {0x11A59, 0x11A5B}, {0x11A8A, 0x11A96}, {0x11A98, 0x11A99}, {0x11C30, 0x11C36},
+    {0x11C38, 0x11C3D}, {0x11C3F, 0x11C3F}, {0x11C92, 0x11CA7}, {0x11CAA, 0x11CB0}, {0x11CB2, 0x11CB3},
+    {0x11CB5, 0x11CB6}, {0x11D31, 0x11D36}, {0x11D3A, 0x11D3A}, {0x11D3C, 0x11D3D}, {0x11D3F, 0x11D45},
+    {0x11D47, 0x11D47}, {0x11D90, 0x11D91}, {0x11D95, 0x11D95}, {0x11D97, 0x11D97}, {0x11EF3, 0x11EF4},
+    {0x13430, 0x13438}, {0x16AF0, 0x16AF4}, {0x16B30, 0x16B36}, {0x16F4F, 0x16F4F}, {0x16F8F, 0x16F92},
+    {0x16FE4, 0x16FE4}, {0x1BC9D, 0x1BC9E}, {0x1BCA0, 0x1BCA3}, {0x1CF00, 0x1CF2D}, {0x1CF30, 0x1CF46},
+    {0x1D167, 0x1D169}, {0x1D173, 0x1D182}, {0x1D185, 0x1D18B}, {0x1D1AA, 0x1D1AD}, {0x1D242, 0x1D244},
+    {0x1DA00, 0x1DA36}, {0x1DA3B, 0x1DA6C}, {0x1DA75, 0x1DA75}, {0x1DA84, 0x1DA84}, {0x1DA9B, 0x1DA9F},
+    {0x1DAA1, 0x1DAAF}, {0x1E000, 0x1E006}, {0x1E008, 0x1E018}, {0x1E01B, 0x1E021}, {0x1E023, 0x1E024},
+    {0x1E026, 0x1E02A}, {0x1E130, 0x1E136}, {0x1E2AE, 0x1E2AE}, {0x1E2EC, 0x1E2EF}, {0x1E8D0, 0x1E8D6},
+    {0x1E944, 0x1E94A}, {0x1F3FB, 0x1F3FF}, {0xE0001, 0xE0001}, {0xE0020, 0xE007F}, {0xE0100, 0xE01EF}
+};
+
+// Width of every code point: 1 unless listed
+std::vector<uint8_t> ReferenceWidths()
+{
+    std::vector<uint8_t> widths(0x110000, 1);
+    for (const WidthRange& range : s_wideRanges)
+    {
+        std::fill(widths.begin() + range.first, widths.begin() + range.last + 1, 2);
+    }
+    for (const WidthRange& range : s_zeroWidthRanges)
+    {
+        std::fill(widths.begin() + range.first, widths.begin() + range.last + 1, 0);
+    }
+    return widths;
+}
+
+std::string EncodeUtf8(uint32_t codePoint)
+{
+    if (codePoint < 0x80)
+    {
+        return std::string(1, static_cast<char>(codePoint));
+    }
+    if (codePoint < 0x800)
+    {
+        return {static_cast<char>(0xC0 | codePoint >> 6), static_cast<char>(0x80 | (codePoint & 0x3F))};
+    }
+    if (codePoint < 0x10000)
+    {
+        return {static_cast<char>(0xE0 | codePoint >> 12), static_cast<char>(0x80 | (codePoint >> 6 & 0x3F)),
+                static_cast<char>(0x80 | (codePoint & 0x3F))};
+    }
+    return {static_cast<char>(0xF0 | codePoint >> 18), static_cast<char>(0x80 | (codePoint >> 12 & 0x3F)),
+            static_cast<char>(0x80 | (codePoint >> 6 & 0x3F)), static_cast<char>(0x80 | (codePoint & 0x3F))};
+}
+
+TEST(DisplayWidth, TableMatchesRanges)
+{
+    const std::vector<uint8_t> widths = ReferenceWidths();
+    for (uint32_t codePoint = 0x80; codePoint < widths.size(); ++codePoint)
+    {
+        ASSERT_EQ(widths[codePoint], CodePointWidth(codePoint)) << std::hex << codePoint;
+    }
+}
+
+// Every zero width code point joins the cluster of the character before it, whatever its lead byte
+TEST(DisplayWidth, ZeroWidthExtendsCluster)
+{
+    const std::vector<uint8_t> widths = ReferenceWidths();
+    for (uint32_t codePoint = 0x80; codePoint < widths.size(); ++codePoint)
+    {
+        if (widths[codePoint] != 0 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+        {
+            continue;
+        }
+        const std::string text = "a" + EncodeUtf8(codePoint);
+        unsigned width = 0;
+        ASSERT_EQ(text.size(), NextGraphemeCluster(text.data(), text.size(), 0, width)) << std::hex << codePoint;
+        ASSERT_EQ(1u, width) << std::hex << codePoint;
+    }
+}
+
+// Prints s_blockIndex, s_blocks and s_extendingLeads of displaywidth.cpp for the ranges above
+TEST(DisplayWidth, DISABLED_PrintTable)
+{
+    const std::vector<uint8_t> widths = ReferenceWidths();
+    std::vector<uint32_t> leads(256 / 32);
+    for (uint32_t codePoint = 0x80; codePoint < widths.size(); ++codePoint)
+    {
+        if (widths[codePoint] == 0 && (codePoint < 0xD800 || codePoint > 0xDFFF))
+        {
+            const unsigned char lead = static_cast<unsigned char>(EncodeUtf8(codePoint)[0]);
+            leads[lead / 32] |= 1u << (lead % 32);
+        }
+    }
+    std::vector<std::vector<uint8_t>> blocks;
+    std::vector<size_t> index;
+    for (size_t first = 0; first < widths.size(); first += 256)
+    {
+        std::vector<uint8_t> packed(64);
+        for (size_t i = 0; i < 256; ++i)
+        {
+            packed[i / 4] |= static_cast<uint8_t>(widths[first + i] << (i % 4 * 2));
+        }
+        const auto found = std::find(blocks.begin(), blocks.end(), packed);
+        index.push_back(found - blocks.begin());
+        if (found == blocks.end())
+        {
+            blocks.push_back(packed);
+        }
+    }
+    std::ostringstream text;
+    text << "    const uint8_t s_blockIndex[s_codePointCount / s_blockSize] = {";
+    for (size_t i = 0; i < index.size(); ++i)
+    {
+        text << (i % 24 == 0 ? "\n        " : " ") << index[i] << (i + 1 < index.size() ? "," : "\n    };\n");
+    }
+    text << "\n    const WidthBlock s_blocks[] = {";
+    for (size_t block = 0; block < blocks.size(); ++block)
+    {
+        text << "\n        {{";
+        for (size_t i = 0; i < 64; ++i)
+        {
+            text << (i % 16 == 0 ? "\n            " : " ") << "0x" << std::hex << std::uppercase
+                 << static_cast<unsigned>(blocks[block][i] >> 4) << static_cast<unsigned>(blocks[block][i] & 15)
+                 << std::dec << (i + 1 < 64 ? "," : "");
+        }
+        text << "\n        }}" << (block + 1 < blocks.size() ? "," : "\n    };\n");
+    }
+    text << "\n    const uint32_t s_extendingLeads[256 / 32] = {\n        " << std::hex << std::uppercase;
+    for (size_t i = 0; i < leads.size(); ++i)
+    {
+        text << "0x" << std::setw(8) << std::setfill('0') << leads[i] << (i + 1 < leads.size() ? ", " : "\n    };\n");
+    }
+    std::cout << text.str();
+}
+
+std::string RepeatWords(const std::vector<std::string>& words, size_t size)
+{
+    std::string text;
+    uint32_t seed = 12345;
+    while (text.size() < size)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        text += words[(seed >> 16) % words.size()] + ' ';
+    }
+    return text;
+}
+
+TEST(WrapStringDisplayWidthBenchmark, DISABLED_Corpora)
+{
+    const size_t size = 16 << 20;
+    const std::pair<const char*, std::string> corpora[] = {
+        {"ASCII", RepeatWords({"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog"}, size)},
+        {"Latin-1", RepeatWords({"caf\xC3\xA9", "na\xC3\xAFve", "fa\xC3\xA7" "ade", "jalape\xC3\xB1o", "k\xC3\xB8" "d", "und"}, size)},
+        {"CJK", RepeatWords({"\xE6\xBC\xA2\xE5\xAD\x97", "\xE3\x81\x8B\xE3\x81\xAA", "\xED\x95\x9C\xEA\xB8\x80", "\xE4\xB8\xAD\xE6\x96\x87\xE5\xAD\x97"}, size)}
+    };
+
+    LineSpans lines;
+    for (const auto& corpus : corpora)
+    {
+        for (WrapMode mode : {WrapMode::Greedy, WrapMode::DisplayWidth})
+        {
+            const auto start = std::chrono::steady_clock::now();
+            WrapSpans(corpus.second, 80, lines, mode);
+            const auto time = std::chrono::steady_clock::now() - start;
+            std::cout << corpus.first << (mode == WrapMode::Greedy ? " bytes: " : " columns: ")
+                      << corpus.second.size() / std::chrono::duration<double, std::micro>(time).count() << " MB/s, "
+                      << lines.size() << " lines" << std::endl;
+        }
+    }
+}
+
+TEST(ThreadPool, RunsEveryTaskOnce)
+{
+    ThreadPool pool(4);
+    ASSERT_EQ(4u, pool.ThreadCount());
+    for (size_t taskCount : {0, 1, 3, 1000})
+    {
+        std::vector<std::atomic<int>> calls(taskCount);
+        pool.Run(taskCount, [&calls](size_t index)
+        {
+            ++calls[index];
+        });
+        for (const std::atomic<int>& count : calls)
+        {
+            ASSERT_EQ(1, count.load());
+        }
+    }
+}
+
+TEST(WrapDocument, Empty)
+{
+    ThreadPool pool(2);
+    ASSERT_EQ("", WrapDocument("", 10, pool));
+    ASSERT_EQ("", WrapDocument(" \n\n  \n", 10, pool));
+    ASSERT_EQ("", WrapDocument("text", 0, pool));
+}
+
+TEST(WrapDocument, SingleParagraph)
+{
+    ThreadPool pool(2);
+    ASSERT_EQ("When pos\nis\nspecified\n", WrapDocument("When pos is specified", 9, pool));
+}
+
+TEST(WrapDocument, LineFeedsInsideParagraphAreSpaces)
+{
+    ThreadPool pool(2);
+    ASSERT_EQ("a b c\nd\n", WrapDocument("a\nb\nc d\n", 5, pool));
+}
+
+TEST(WrapDocument, ParagraphsSeparatedByOneEmptyLine)
+{
+    ThreadPool pool(2);
+    ASSERT_EQ("first\n\nsecond\npart\n\nthird\n", WrapDocument("\n  \nfirst\n\n\n   \nsecond part\n \nthird", 6, pool));
+}
+
+// Paragraph by paragraph with WrapString
+std::string WrapDocumentSerially(const std::string& text, size_t wrapLength)
+{
+    std::vector<std::string> paragraphs(1);
+    std::istringstream lines(text);
+    for (std::string line; std::getline(lines, line);)
+    {
+        if (line.find_first_not_of(' ') != std::string::npos)
+        {
+            paragraphs.back() += line + ' ';
+        }
+        else if (!paragraphs.back().empty())
+        {
+            paragraphs.emplace_back();
+        }
+    }
+
+    std::string result;
+    for (const std::string& paragraph : paragraphs)
+    {
+        if (!result.empty() && !paragraph.empty())
+        {
+            result += '\n';
+        }
+        for (const std::string& line : WrapString(paragraph, wrapLength))
+        {
+            result += line + '\n';
+        }
+    }
+    return result;
+}
+
+// Paragraphs of 1 to 40 lines of random words with runs of blank lines between them
+std::string MakeDocument(size_t size)
+{
+    const char* words[] = {"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "Antidisestablishmentarianism"};
+    std::string text;
+    uint32_t seed = 12345;
+    auto random = [&seed](uint32_t range)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 16) % range;
+    };
+    while (text.size() < size)
+    {
+        for (uint32_t line = random(40); line-- > 0;)
+        {
+            for (uint32_t word = random(12); word-- > 0;)
+            {
+                text += std::string(random(3), ' ') + words[random(9)];
+            }
+            text += '\n';
+        }
+        for (uint32_t blank = random(3) + 1; blank-- > 0;)
+        {
+            text += std::string(random(2), ' ') + '\n';
+        }
+    }
+    return text;
+}
+
+TEST(WrapDocument, MatchesSerialWrapping)
+{
+    const std::string text = MakeDocument(1 << 20);
+    for (size_t threadCount : {1, 2, 3, 8})
+    {
+        ThreadPool pool(threadCount);
+        for (size_t wrapLength : {7, 40, 80})
+        {
+            ASSERT_EQ(WrapDocumentSerially(text, wrapLength), WrapDocument(text, wrapLength, pool))
+                    << threadCount << " threads, wrap length " << wrapLength;
+        }
+    }
+}
+
+TEST(WrapDocumentBenchmark, DISABLED_Scaling)
+{
+    const std::string text = MakeDocument(256 << 20);
+    const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t threadCount = 1; threadCount <= hardwareThreads; threadCount *= 2)
+    {
+        ThreadPool pool(threadCount);
+        std::string wrapped;
+        WrapDocument(text, 80, pool, wrapped);
+        const auto start = std::chrono::steady_clock::now();
+        WrapDocument(text, 80, pool, wrapped);
+        const auto time = std::chrono::steady_clock::now() - start;
+        std::cout << threadCount << " threads: "
+                  << text.size() / std::chrono::duration<double, std::micro>(time).count() << " MB/s, "
+                  << wrapped.size() << " bytes written" << std::endl;
+    }
+}
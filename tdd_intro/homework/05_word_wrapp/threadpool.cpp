@@ -0,0 +1,95 @@
+#include "threadpool.h"
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : m_task(nullptr), m_taskCount(0), m_generation(0), m_busyWorkers(0), m_stop(false), m_next(0)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    for (size_t i = 1; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::ThreadCount() const
+{
+    return m_workers.size() + 1;
+}
+
+void ThreadPool::Run(size_t taskCount, const Task& task)
+{
+    if (m_workers.empty() || taskCount <= 1)
+    {
+        for (size_t index = 0; index < taskCount; ++index)
+        {
+            task(index);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_taskCount = taskCount;
+        m_next.store(0, std::memory_order_relaxed);
+        m_busyWorkers = m_workers.size();
+        ++m_generation;
+    }
+    m_wake.notify_all();
+    RunTasks(task, taskCount);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+    size_t generation = 0;
+    for (;;)
+    {
+        const Task* task = nullptr;
+        size_t taskCount = 0;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+            task = m_task;
+            taskCount = m_taskCount;
+        }
+        RunTasks(*task, taskCount);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busyWorkers == 0)
+        {
+            m_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunTasks(const Task& task, size_t taskCount)
+{
+    for (size_t index = m_next.fetch_add(1, std::memory_order_relaxed); index < taskCount;
+         index = m_next.fetch_add(1, std::memory_order_relaxed))
+    {
+        task(index);
+    }
+}
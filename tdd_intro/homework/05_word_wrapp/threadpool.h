@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Fixed set of worker threads running batches of indexed tasks.
+ *
+ * Run hands out task indices through a shared atomic counter, so threads which finish early take more tasks.
+ * The calling thread works on the batch too and Run returns only when every task is done.
+ * Batches are run one at a time: Run must not be called concurrently or from inside a task,
+ * and tasks must not throw.
+*/
+
+class ThreadPool
+{
+public:
+    using Task = std::function<void(size_t index)>;
+
+    // threadCount includes the calling thread, 0 means one thread per hardware thread
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t ThreadCount() const;
+    // Calls task(index) for every index below taskCount
+    void Run(size_t taskCount, const Task& task);
+
+private:
+    void WorkerLoop();
+    void RunTasks(const Task& task, size_t taskCount);
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Task* m_task;
+    size_t m_taskCount;
+    size_t m_generation;
+    size_t m_busyWorkers;
+    bool m_stop;
+    std::atomic<size_t> m_next;
+};
@@ -0,0 +1,605 @@
+#include "wordwrap.h"
+#include "displaywidth.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <utility>
+
+namespace
+{
+    struct Word
+    {
+        size_t begin;
+        size_t end;
+    };
+
+    using Words = std::vector<Word>;
+
+    const uint64_t s_infiniteCost = std::numeric_limits<uint64_t>::max();
+
+    // Characters lines are broken at, documents also break at the line ends of the source text
+    struct Space
+    {
+        static bool Is(char c)
+        {
+            return c == ' ';
+        }
+    };
+
+    struct SpaceOrNewline
+    {
+        static bool Is(char c)
+        {
+            return c == ' ' || c == '\n';
+        }
+    };
+
+    template <typename Separator = Space>
+    size_t SkipSpaces(const char* str, size_t size, size_t pos)
+    {
+        while (pos < size && Separator::Is(str[pos]))
+        {
+            ++pos;
+        }
+        return pos;
+    }
+
+    template <typename Separator = Space>
+    size_t TrimSpaces(const char* str, size_t begin, size_t end)
+    {
+        while (end > begin && Separator::Is(str[end - 1]))
+        {
+            --end;
+        }
+        return end;
+    }
+
+    // Breaks a line starting at a non-space character when more than wrapLength characters follow.
+    // Sets lineEnd to the end of the line text and returns where the rest of text starts (possibly with spaces).
+    template <typename Separator = Space>
+    size_t BreakLine(const char* line, size_t wrapLength, size_t& lineEnd)
+    {
+        // The character right after the limit may be a space too, then the whole window fits
+        size_t space = wrapLength;
+        while (space > 0 && !Separator::Is(line[space]))
+        {
+            --space;
+        }
+        if (space == 0)
+        {
+            lineEnd = wrapLength;
+            return wrapLength;
+        }
+        lineEnd = TrimSpaces<Separator>(line, 0, space);
+        return space;
+    }
+
+    // Calls emit(begin, end) for every line
+    template <typename Separator = Space, typename Emit>
+    void WrapGreedy(const char* str, size_t size, size_t wrapLength, Emit emit)
+    {
+        size_t pos = SkipSpaces<Separator>(str, size, 0);
+        while (pos < size)
+        {
+            if (size - pos <= wrapLength)
+            {
+                emit(pos, TrimSpaces<Separator>(str, pos, size));
+                break;
+            }
+            size_t lineEnd = 0;
+            const size_t next = pos + BreakLine<Separator>(str + pos, wrapLength, lineEnd);
+            emit(pos, pos + lineEnd);
+            pos = SkipSpaces<Separator>(str, size, next);
+        }
+    }
+
+    // Same as BreakLine, but wrapLength is in display columns and lines are broken between grapheme clusters
+    size_t BreakDisplayLine(const char* str, size_t size, size_t pos, size_t wrapLength, size_t& lineEnd)
+    {
+        const size_t begin = pos;
+        size_t lastSpace = begin;
+        size_t columns = 0;
+        while (pos < size)
+        {
+            unsigned width = 0;
+            const size_t next = NextGraphemeCluster(str, size, pos, width);
+            if (columns + width > wrapLength)
+            {
+                if (str[pos] == ' ')
+                {
+                    lastSpace = pos;
+                }
+                if (lastSpace > begin)
+                {
+                    lineEnd = TrimSpaces(str, begin, lastSpace);
+                    return lastSpace;
+                }
+                // A cluster wider than the whole line still goes into a line of its own
+                lineEnd = pos > begin ? pos : next;
+                return lineEnd;
+            }
+            if (str[pos] == ' ')
+            {
+                lastSpace = pos;
+            }
+            columns += width;
+            pos = next;
+        }
+        lineEnd = TrimSpaces(str, begin, size);
+        return size;
+    }
+
+    template <typename Emit>
+    void WrapDisplayWidth(const char* str, size_t size, size_t wrapLength, Emit emit)
+    {
+        size_t pos = SkipSpaces(str, size, 0);
+        while (pos < size)
+        {
+            // Plain ASCII takes a column per byte, so the byte counting break is exact and faster
+            const size_t window = size - pos <= wrapLength ? size - pos : wrapLength + 1;
+            size_t lineEnd = 0;
+            size_t next = 0;
+            if (IsAscii(str + pos, window))
+            {
+                if (size - pos <= wrapLength)
+                {
+                    emit(pos, TrimSpaces(str, pos, size));
+                    break;
+                }
+                next = pos + BreakLine(str + pos, wrapLength, lineEnd);
+                lineEnd += pos;
+            }
+            else
+            {
+                next = BreakDisplayLine(str, size, pos, wrapLength, lineEnd);
+            }
+            emit(pos, lineEnd);
+            pos = SkipSpaces(str, size, next);
+        }
+    }
+
+    // Words separated by spaces, words longer than wrapLength are cut into pieces
+    Words SplitWords(const std::string& str, size_t wrapLength)
+    {
+        Words words;
+        size_t pos = SkipSpaces(str.data(), str.size(), 0);
+        while (pos < str.size())
+        {
+            size_t end = pos;
+            while (end < str.size() && str[end] != ' ' && end - pos < wrapLength)
+            {
+                ++end;
+            }
+            words.push_back(Word{pos, end});
+            pos = SkipSpaces(str.data(), str.size(), end);
+        }
+        return words;
+    }
+
+    class RaggednessCost
+    {
+    public:
+        RaggednessCost(const Words& words, size_t wrapLength)
+            : m_words(words), m_wrapLength(wrapLength)
+        { }
+
+        bool Fits(size_t first, size_t end) const
+        {
+            return m_words[end - 1].end - m_words[first].begin <= m_wrapLength;
+        }
+
+        // Cost of a line with words [first, end)
+        uint64_t operator()(size_t first, size_t end) const
+        {
+            if (!Fits(first, end))
+            {
+                return s_infiniteCost;
+            }
+            const uint64_t space = m_wrapLength - (m_words[end - 1].end - m_words[first].begin);
+            return space * space;
+        }
+
+    private:
+        const Words& m_words;
+        size_t m_wrapLength;
+    };
+
+    void WrapMinimumRaggedness(const std::string& str, size_t wrapLength, LineSpans& lines)
+    {
+        const Words words = SplitWords(str, wrapLength);
+        const size_t count = words.size();
+        if (count == 0)
+        {
+            return;
+        }
+        const RaggednessCost cost(words, wrapLength);
+
+        // best[j] is the cost of wrapping words [0, j), lineStart[j] is the first word of its last line
+        std::vector<uint64_t> best(count + 1, s_infiniteCost);
+        std::vector<size_t> lineStart(count + 1, 0);
+        // reach[i] is the first line end which does not fit when the line starts with word i
+        std::vector<size_t> reach(count + 1, count + 1);
+        for (size_t first = 0, end = 1; first < count; ++first)
+        {
+            end = end > first + 1 ? end : first + 1;
+            while (end <= count && cost.Fits(first, end))
+            {
+                ++end;
+            }
+            reach[first] = end;
+        }
+
+        auto total = [&](size_t first, size_t end) -> uint64_t
+        {
+            const uint64_t line = cost(first, end);
+            return line == s_infiniteCost ? s_infiniteCost : best[first] + line;
+        };
+        // Once a later start is not worse than an earlier one, it stays so for all further ends
+        auto notWorse = [&](size_t later, size_t earlier, size_t end)
+        {
+            return total(later, end) <= total(earlier, end);
+        };
+
+        struct Candidate
+        {
+            size_t first;
+            size_t fromEnd;
+        };
+        std::deque<Candidate> candidates;
+        best[0] = 0;
+        candidates.push_back(Candidate{0, 1});
+        for (size_t end = 1; end <= count; ++end)
+        {
+            while (candidates.size() > 1 && candidates[1].fromEnd <= end)
+            {
+                candidates.pop_front();
+            }
+            best[end] = total(candidates.front().first, end);
+            lineStart[end] = candidates.front().first;
+            if (end == count)
+            {
+                break;
+            }
+
+            const size_t first = end;
+            while (!candidates.empty() &&
+                   notWorse(first, candidates.back().first, std::max(candidates.back().fromEnd, first + 1)))
+            {
+                candidates.pop_back();
+            }
+            if (candidates.empty())
+            {
+                candidates.push_back(Candidate{first, first + 1});
+                continue;
+            }
+            // Past reach of the tail candidate the new one is always better
+            size_t low = std::max(candidates.back().fromEnd, first + 1);
+            size_t high = std::min(reach[candidates.back().first], count + 1);
+            while (low < high)
+            {
+                const size_t middle = low + (high - low) / 2;
+                if (notWorse(first, candidates.back().first, middle))
+                {
+                    high = middle;
+                }
+                else
+                {
+                    low = middle + 1;
+                }
+            }
+            if (low <= count)
+            {
+                candidates.push_back(Candidate{first, low});
+            }
+        }
+
+        // The last line is free, pick the cheapest start among those which fit
+        size_t lastStart = count - 1;
+        for (size_t first = count - 1; first-- > 0 && cost.Fits(first, count);)
+        {
+            if (best[first] <= best[lastStart])
+            {
+                lastStart = first;
+            }
+        }
+
+        lines.push_back(LineSpan{words[lastStart].begin, words[count - 1].end - words[lastStart].begin});
+        for (size_t end = lastStart; end > 0; end = lineStart[end])
+        {
+            const size_t begin = words[lineStart[end]].begin;
+            lines.push_back(LineSpan{begin, words[end - 1].end - begin});
+        }
+        std::reverse(lines.begin(), lines.end());
+    }
+
+    // Input bytes of one document task, tasks are cut only at blank lines so no paragraph is split
+    const size_t s_documentTaskBytes = 1 << 16;
+
+    size_t LineEnd(const char* str, size_t size, size_t pos)
+    {
+        const void* newline = std::memchr(str + pos, '\n', size - pos);
+        return newline ? static_cast<const char*>(newline) - str : size;
+    }
+
+    bool IsBlankLine(const char* str, size_t begin, size_t end)
+    {
+        return SkipSpaces(str, end, begin) == end;
+    }
+
+    // Returns the start of the first blank line starting after pos, or size if there is none
+    size_t NextBlankLine(const char* str, size_t size, size_t pos)
+    {
+        pos = LineEnd(str, size, pos);
+        while (pos < size)
+        {
+            const size_t begin = pos + 1;
+            pos = LineEnd(str, size, begin);
+            if (IsBlankLine(str, begin, pos))
+            {
+                return begin;
+            }
+        }
+        return size;
+    }
+
+    struct DocumentTask
+    {
+        size_t begin;
+        size_t end;
+        // Lines of all paragraphs of the task, every paragraph is preceded by an empty separator line
+        LineSpans lines;
+        // The first separator of the document is not written
+        size_t firstLine;
+        size_t outputOffset;
+    };
+
+    void WrapDocumentTask(const char* str, size_t wrapLength, DocumentTask& task)
+    {
+        size_t paragraphBegin = task.begin;
+        size_t pos = task.begin;
+        while (pos < task.end)
+        {
+            const size_t lineEnd = LineEnd(str, task.end, pos);
+            const bool blank = IsBlankLine(str, pos, lineEnd);
+            const size_t next = lineEnd + 1;
+            if (blank || next >= task.end)
+            {
+                const size_t paragraphEnd = blank ? pos : task.end;
+                const size_t first = SkipSpaces<SpaceOrNewline>(str, paragraphEnd, paragraphBegin);
+                if (first < paragraphEnd)
+                {
+                    task.lines.push_back(LineSpan{first, 0});
+                    WrapGreedy<SpaceOrNewline>(str + first, paragraphEnd - first, wrapLength,
+                                               [&](size_t begin, size_t end)
+                    {
+                        task.lines.push_back(LineSpan{first + begin, end - begin});
+                    });
+                }
+                paragraphBegin = next;
+            }
+            pos = next;
+        }
+    }
+
+    // Copies size bytes turning every '\n' into ' ', eight bytes at a time
+    void CopyReplacingLineFeeds(char* out, const char* str, size_t size)
+    {
+        const uint64_t ones = 0x0101010101010101ull;
+        const uint64_t low7 = 0x7F7F7F7F7F7F7F7Full;
+        size_t pos = 0;
+        for (; pos + 8 <= size; pos += 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, str + pos, 8);
+            const uint64_t diff = word ^ (ones * '\n');
+            // High bit set exactly in the bytes equal to '\n'
+            const uint64_t match = ~(((diff & low7) + low7) | diff) & ~low7;
+            word ^= (match >> 7) * ('\n' ^ ' ');
+            std::memcpy(out + pos, &word, 8);
+        }
+        for (; pos < size; ++pos)
+        {
+            out[pos] = str[pos] == '\n' ? ' ' : str[pos];
+        }
+    }
+
+    // Writes lines of the task each followed by a line feed, line feeds inside lines become spaces
+    void WriteDocumentTask(const char* str, const DocumentTask& task, char* output)
+    {
+        char* out = output + task.outputOffset;
+        for (size_t i = task.firstLine; i < task.lines.size(); ++i)
+        {
+            const LineSpan& line = task.lines[i];
+            CopyReplacingLineFeeds(out, str + line.offset, line.length);
+            out += line.length;
+            *out++ = '\n';
+        }
+    }
+}
+
+void WrapSpans(const std::string& str, size_t wrapLength, LineSpans& lines, WrapMode mode)
+{
+    lines.clear();
+    if (wrapLength == 0)
+    {
+        return;
+    }
+    auto emit = [&lines](size_t begin, size_t end)
+    {
+        lines.push_back(LineSpan{begin, end - begin});
+    };
+    switch (mode)
+    {
+    case WrapMode::Greedy:
+        WrapGreedy(str.data(), str.size(), wrapLength, emit);
+        break;
+    case WrapMode::MinimumRaggedness:
+        WrapMinimumRaggedness(str, wrapLength, lines);
+        break;
+    case WrapMode::DisplayWidth:
+        WrapDisplayWidth(str.data(), str.size(), wrapLength, emit);
+        break;
+    }
+}
+
+size_t WrapSpans(const char* str, size_t size, size_t wrapLength, LineSpan* lines, size_t capacity)
+{
+    size_t count = 0;
+    if (wrapLength == 0)
+    {
+        return count;
+    }
+    WrapGreedy(str, size, wrapLength, [&](size_t begin, size_t end)
+    {
+        if (count < capacity)
+        {
+            lines[count] = LineSpan{begin, end - begin};
+        }
+        ++count;
+    });
+    return count;
+}
+
+WrappedStrings WrapString(const std::string& str, size_t wrapLength, WrapMode mode)
+{
+    LineSpans lines;
+    WrapSpans(str, wrapLength, lines, mode);
+    WrappedStrings result;
+    result.reserve(lines.size());
+    for (const LineSpan& line : lines)
+    {
+        result.push_back(str.substr(line.offset, line.length));
+    }
+    return result;
+}
+
+void WrapDocument(const std::string& text, size_t wrapLength, ThreadPool& pool, std::string& output)
+{
+    output.clear();
+    if (wrapLength == 0)
+    {
+        return;
+    }
+    const char* str = text.data();
+    const size_t size = text.size();
+    std::vector<DocumentTask> tasks;
+    for (size_t begin = 0; begin < size;)
+    {
+        const size_t end = size - begin <= s_documentTaskBytes
+                ? size
+                : NextBlankLine(str, size, begin + s_documentTaskBytes);
+        tasks.push_back(DocumentTask{begin, end, LineSpans(), 0, 0});
+        begin = end;
+    }
+
+    pool.Run(tasks.size(), [&](size_t index)
+    {
+        WrapDocumentTask(str, wrapLength, tasks[index]);
+    });
+
+    size_t outputSize = 0;
+    bool firstParagraph = true;
+    for (DocumentTask& task : tasks)
+    {
+        if (firstParagraph && !task.lines.empty())
+        {
+            task.firstLine = 1;
+            firstParagraph = false;
+        }
+        task.outputOffset = outputSize;
+        for (size_t i = task.firstLine; i < task.lines.size(); ++i)
+        {
+            outputSize += task.lines[i].length + 1;
+        }
+    }
+    output.resize(outputSize);
+
+    char* out = &output[0];
+    pool.Run(tasks.size(), [&](size_t index)
+    {
+        WriteDocumentTask(str, tasks[index], out);
+    });
+}
+
+std::string WrapDocument(const std::string& text, size_t wrapLength, ThreadPool& pool)
+{
+    std::string output;
+    WrapDocument(text, wrapLength, pool, output);
+    return output;
+}
+
+StreamingWrapper::StreamingWrapper(size_t wrapLength, LineSink sink)
+    : m_wrapLength(wrapLength), m_sink(std::move(sink))
+{
+    m_line.reserve(wrapLength + 1);
+}
+
+void StreamingWrapper::Write(const char* data, size_t size)
+{
+    if (m_wrapLength == 0)
+    {
+        return;
+    }
+    size_t pos = 0;
+    while (pos < size)
+    {
+        if (m_line.empty())
+        {
+            // At the start of a line, wrap straight from data while a whole window is available
+            pos = SkipSpaces(data, size, pos);
+            if (pos == size)
+            {
+                break;
+            }
+            if (size - pos <= m_wrapLength)
+            {
+                m_line.assign(data + pos, size - pos);
+                break;
+            }
+            size_t lineEnd = 0;
+            const size_t next = BreakLine(data + pos, m_wrapLength, lineEnd);
+            m_sink(data + pos, lineEnd);
+            pos += next;
+            continue;
+        }
+
+        const size_t carried = m_line.size();
+        const size_t taken = std::min(m_wrapLength + 1 - carried, size - pos);
+        m_line.append(data + pos, taken);
+        if (m_line.size() <= m_wrapLength)
+        {
+            break;
+        }
+        size_t lineEnd = 0;
+        const size_t next = BreakLine(m_line.data(), m_wrapLength, lineEnd);
+        m_sink(m_line.data(), lineEnd);
+        if (next >= carried)
+        {
+            // The rest of the line is still in data, continue from there
+            pos += next - carried;
+            m_line.clear();
+        }
+        else
+        {
+            pos += taken;
+            m_line.erase(0, SkipSpaces(m_line.data(), m_line.size(), next));
+        }
+    }
+}
+
+void StreamingWrapper::Write(const std::string& data)
+{
+    Write(data.data(), data.size());
+}
+
+void StreamingWrapper::Finish()
+{
+    if (!m_line.empty())
+    {
+        m_sink(m_line.data(), TrimSpaces(m_line.data(), 0, m_line.size()));
+        m_line.clear();
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+ * Word wrapping engine.
+ *
+ * Lines are broken at spaces, all spaces at a break are dropped, spaces inside a line are kept.
+ * A word longer than the wrap length is cut into pieces of exactly the wrap length.
+ *
+ * Greedy mode puts as many words as possible into each line, i.e. breaks at the last space under the limit.
+ * MinimumRaggedness mode minimizes the sum of squared free space of all lines except the last one (Knuth-Plass
+ * without hyphenation). Line costs are a convex function of line length, so candidate line starts are kept in a
+ * monotone queue where each one owns a range of line ends; a new candidate replaces the queue tail from the point
+ * it becomes better, which is found by binary search bounded by the wrap length.
+ * This takes O(n log w) time for n words and wrap length w instead of O(n^2) of the plain dynamic programming.
+ * DisplayWidth mode is greedy mode which counts display columns of grapheme clusters instead of bytes
+ * (see displaywidth.h) and never splits a cluster. Windows of plain ASCII take the byte counting path.
+ *
+ * WrapSpans returns lines as offset/length pairs into the original text and performs no allocation per line:
+ * the vector overload reuses the capacity of the given vector, the buffer overload (greedy mode only)
+ * never allocates. MinimumRaggedness mode allocates its working arrays once per call.
+ *
+ * StreamingWrapper wraps text arriving in chunks exactly as greedy WrapString does for the whole text.
+ * It keeps at most wrapLength + 1 characters of the current line between chunks
+ * and passes lines straight from the chunk to the sink whenever it can.
+ *
+ * WrapDocument wraps a document of paragraphs separated by blank lines (lines of spaces only),
+ * line feeds inside a paragraph are spaces. The text is cut at blank lines into tasks of about 64 KB which
+ * are wrapped in greedy mode on a thread pool; a second parallel pass copies every task's lines to its
+ * precomputed offset of the single output buffer.
+*/
+
+class ThreadPool;
+
+using WrappedStrings = std::vector<std::string>;
+
+enum class WrapMode
+{
+    Greedy,
+    MinimumRaggedness,
+    // Greedy on UTF-8 text, wrap length is in terminal columns
+    DisplayWidth
+};
+
+struct LineSpan
+{
+    size_t offset;
+    size_t length;
+
+    bool operator==(const LineSpan& right) const
+    {
+        return offset == right.offset && length == right.length;
+    }
+};
+
+using LineSpans = std::vector<LineSpan>;
+
+WrappedStrings WrapString(const std::string& str, size_t wrapLength, WrapMode mode = WrapMode::Greedy);
+
+// Replaces content of lines with the wrapped lines of str
+void WrapSpans(const std::string& str, size_t wrapLength, LineSpans& lines, WrapMode mode = WrapMode::Greedy);
+// Writes up to capacity lines into lines and returns the total number of lines,
+// a result above capacity means the buffer was too small and only its first capacity lines are valid
+size_t WrapSpans(const char* str, size_t size, size_t wrapLength, LineSpan* lines, size_t capacity);
+
+// Returns wrapped lines each followed by '\n', paragraphs are separated by one empty line
+std::string WrapDocument(const std::string& text, size_t wrapLength, ThreadPool& pool);
+// Replaces content of output with the wrapped document, reusing its capacity
+void WrapDocument(const std::string& text, size_t wrapLength, ThreadPool& pool, std::string& output);
+
+class StreamingWrapper
+{
+public:
+    // Receives each completed line, the pointer is valid only during the call
+    using LineSink = std::function<void(const char* line, size_t length)>;
+
+    StreamingWrapper(size_t wrapLength, LineSink sink);
+
+    void Write(const char* data, size_t size);
+    void Write(const std::string& data);
+    // Passes the last line to the sink, call it at the end of input
+    void Finish();
+
+private:
+    size_t m_wrapLength;
+    LineSink m_sink;
+    // Start of the current line when it does not fit into the last chunk, never starts with a space
+    std::string m_line;
+};